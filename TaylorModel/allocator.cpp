@@ -0,0 +1,64 @@
+﻿#include "allocator.h"
+
+blockPool::~blockPool() {
+	for (void *chunk : _chunks)
+		::operator delete(chunk);
+}
+
+// размер блока округляется так, чтобы все блоки в куске были выровнены
+std::size_t blockPool::blockSize(std::size_t size) {
+	const std::size_t align = alignof(std::max_align_t);
+	size = (size < sizeof(void*)) ? sizeof(void*) : size;
+	return (size + align - 1) / align * align;
+}
+
+blockPool::sizeClass* blockPool::findClass(std::size_t size) {
+	for (sizeClass &c : _classes) {
+		if (c.size == size)
+			return &c;
+	}
+	return nullptr;
+}
+
+void* blockPool::allocate(std::size_t size) {
+	size = blockSize(size);
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	sizeClass *c = findClass(size);
+	if (c == nullptr) {
+		if (_classes.size() >= maxClasses) {
+			allocationCounter()++;
+			return ::operator new(size);
+		}
+		_classes.push_back(sizeClass{ size, nullptr });
+		c = &_classes.back();
+	}
+
+	if (c->free == nullptr) {
+		char *chunk = static_cast<char*>(::operator new(size * chunkBlocks));
+		allocationCounter()++;
+		_chunks.push_back(chunk);
+
+		for (int i = chunkBlocks - 1; i >= 0; i--) {	// первым выдаётся начало куска
+			*reinterpret_cast<void**>(chunk + i * size) = c->free;
+			c->free = chunk + i * size;
+		}
+	}
+
+	void *p = c->free;
+	c->free = *static_cast<void**>(p);
+	return p;
+}
+
+void blockPool::deallocate(void *p, std::size_t size) {
+	size = blockSize(size);
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	sizeClass *c = findClass(size);
+	if (c == nullptr) {
+		::operator delete(p);
+		return;
+	}
+	*static_cast<void**>(p) = c->free;
+	c->free = p;
+}
@@ -0,0 +1,97 @@
+﻿/*
+Распределитель памяти для коэффициентов рядов.
+Считает все выделения памяти под ряды и их служебные массивы,
+по счётчику видно, что в цикле интегрирования память не выделяется.
+
+Ряды, созданные для таблицы multSerCoef, берут память из её пула blockPool:
+все они одной длины, поэтому освобождённый блок сразу идёт следующему ряду,
+а сами блоки лежат рядом в нескольких больших кусках памяти.
+*/
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+
+inline std::atomic<long long>& allocationCounter() {
+	static std::atomic<long long> counter(0);
+	return counter;
+}
+
+// сколько раз выделялась память под ряды с начала работы программы
+// (для рядов из пула считаются только новые куски пула)
+inline long long allocationCount() { return allocationCounter().load(); }
+
+
+// пул блоков одинакового размера; блоков разного размера может быть несколько видов
+class blockPool {
+private:
+	struct sizeClass {
+		std::size_t size;	// размер блока в байтах
+		void *free;			// список свободных блоков: в начале свободного блока лежит адрес следующего
+	};
+	static const int chunkBlocks = 64;	// сколько блоков выделяется за раз
+	static const int maxClasses = 8;	// блоки остальных размеров берутся из кучи
+
+	std::vector<sizeClass> _classes;
+	std::vector<void*> _chunks;
+	std::mutex _mutex;
+
+	sizeClass* findClass(std::size_t);
+	static std::size_t blockSize(std::size_t);
+
+public:
+	blockPool() {};
+	~blockPool();
+	blockPool(const blockPool&) = delete;
+	blockPool& operator=(const blockPool&) = delete;
+
+	void* allocate(std::size_t);
+	void deallocate(void*, std::size_t);
+};
+
+
+template <typename T>
+class seriesAllocator {
+	template <typename U> friend class seriesAllocator;
+
+private:
+	std::shared_ptr<blockPool> _pool;	// пустой - память из кучи
+
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	seriesAllocator() {};
+	explicit seriesAllocator(const std::shared_ptr<blockPool> &pool) : _pool(pool) {};
+	template <typename U> seriesAllocator(const seriesAllocator<U> &a) : _pool(a._pool) {};
+
+	T* allocate(std::size_t n) {
+		if (_pool)
+			return static_cast<T*>(_pool->allocate(n * sizeof(T)));
+
+		allocationCounter()++;
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(T *p, std::size_t n) {
+		if (_pool)
+			_pool->deallocate(p, n * sizeof(T));
+		else
+			::operator delete(p);
+	}
+
+	template <typename U>
+	bool operator==(const seriesAllocator<U> &a) const { return _pool == a._pool; }
+	template <typename U>
+	bool operator!=(const seriesAllocator<U> &a) const { return _pool != a._pool; }
+};
+
+template <typename T>
+using seriesVector = std::vector<T, seriesAllocator<T> >;
@@ -0,0 +1,318 @@
+﻿/*
+Пакет одинаковых систем ОДУ с разными начальными интервалами.
+Таблица коэффициентов multSerCoef (и пул памяти под ряды) считается один раз
+и общая для всех уравнений пакета. RungeKutta ведёт все уравнения по сетке вместе:
+их ряды лежат в batchSeries (k-е коэффициенты всех уравнений подряд), и каждая операция
+этапа Рунге-Кутты - одна операция над всем пакетом, векторизованная по уравнениям
+(правая часть без графа, через pFun, считается для каждого уравнения отдельно).
+Каждое уравнение при этом считается теми же операциями, что и через equation,
+поэтому результат совпадает с расчётом по одному и не зависит от числа потоков.
+
+RungeKuttaSplit делит начальные области пополам, пока остаточный интервал не станет приемлемым
+(см. ниже), enclosure() собирает результаты всех уравнений в одну оценку.
+*/
+
+#pragma once
+#include "odu.h"
+#include "batchSeries.h"
+#include "threadPool.h"
+#include <cmath>
+#include <memory>
+#include <thread>
+
+
+template <typename T>
+class equationBatch {
+private:
+	std::shared_ptr<multSerCoef> coef;
+	vector<std::unique_ptr<equation<T> > > members;
+	vector<vector<interval<T> > > boxes;	// начальные интервалы каждого уравнения
+	std::unique_ptr<threadPool> workers;	// пусто - уравнения пакета считаются последовательно
+	int wrapEvery = 0;						// см. equation::setShrinkWrap
+	std::shared_ptr<const expressionGraph<T> > graph;	// см. equation::setRHS, общий для всех уравнений
+
+	void lockstep(int, int, double, double, double);
+	void rhs(int, const vector<batchSeries<T> >&, const vector<batchSeries<T> >&,
+		vector<batchSeries<T> >&, vector<batchSeries<T> >&) const;
+
+public:
+	equationBatch(int nvar, int param, int order, bool graded = false)
+		: coef(std::make_shared<multSerCoef>(nvar, param, order, graded)) {
+		setThreads(std::thread::hardware_concurrency());
+	};
+
+	inline int size() const { return members.size(); }
+	inline const equation<T>& member(int i) const { return *members.at(i); }
+	inline const vector<interval<T> >& box(int i) const { return boxes.at(i); }
+	inline const std::shared_ptr<multSerCoef>& table() const { return coef; }
+
+	void setThreads(int);
+	void setShrinkWrap(int);
+	void setRHS(const expressionGraph<T>&);
+	void initialFlow(vector<vector<interval<T> > >*);
+	void RungeKutta(double, double, double);
+	void RungeKuttaSplit(double, double, double, T, int = 8);
+	vector<interval<T> > enclosure() const;
+
+private:
+	static T splitPoint(T, T);
+};
+
+template <typename T>
+void equationBatch<T>::setThreads(int threads) {
+	if (threads > 1)
+		workers.reset(new threadPool(threads));
+	else
+		workers.reset();
+}
+
+template <typename T>
+void equationBatch<T>::setShrinkWrap(int steps) {
+	wrapEvery = steps;
+	for (int i = 0; i < size(); i++)
+		members[i]->setShrinkWrap(steps);
+}
+
+// граф компилируется один раз, у каждого уравнения только свои временные ряды
+template <typename T>
+void equationBatch<T>::setRHS(const expressionGraph<T> &g) {
+	auto compiled = std::make_shared<expressionGraph<T> >(g);
+	compiled->compile();
+	graph = compiled;
+	for (int i = 0; i < size(); i++)
+		members[i]->setRHS(graph);
+}
+
+// каждый набор начальных интервалов становится отдельным уравнением пакета (порядок сохраняется)
+template <typename T>
+void equationBatch<T>::initialFlow(vector<vector<interval<T> > > *boxes) {
+	members.clear();
+	members.reserve(boxes->size());
+	this->boxes = *boxes;
+
+	for (int i = 0; i < boxes->size(); i++) {
+		members.push_back(std::unique_ptr<equation<T> >(new equation<T>(coef)));
+		members.back()->initialFlow(&this->boxes[i]);
+		members.back()->setShrinkWrap(wrapEvery);
+		if (graph)
+			members.back()->setRHS(graph);
+	}
+}
+
+/*
+Все уравнения пакета проходят одну и ту же сетку по t вместе (см. lockstep). Потоки получают
+блоки уравнений подряд, не меньше batchLanes в блоке, и каждый блок целиком считает один поток.
+*/
+template <typename T>
+void equationBatch<T>::RungeKutta(double tStart, double tEnd, double h) {
+	if (size() == 0)
+		return;
+
+	// в блоке меньше batchLanes уравнений векторные циклы почти пустые, такой блок поток не получает
+	const int blocks = std::max(1, std::min(size() / batchLanes, workers ? workers->size() : 1));
+	auto step = [&](int b) {
+		lockstep((long long)size() * b / blocks, (long long)size() * (b + 1) / blocks, tStart, tEnd, h);
+	};
+
+	if (blocks > 1)
+		workers->run(blocks, step);
+	else
+		step(0);
+}
+
+// Уравнения [first; last) одним пакетом рядов: те же этапы, что в equation::RungeKutta,
+// но каждая операция - сразу над всеми уравнениями. Ряды берутся из уравнений и в конце
+// записываются обратно; shrinkWrap делает само уравнение (он нужен редко и не векторизуется).
+template <typename T>
+void equationBatch<T>::lockstep(int first, int last, double tStart, double tEnd, double h) {
+	const int M = last - first;
+	const equation<T> &model = *members[first];
+	const int sizeVar = model.sizeVar, size = sizeVar + model.sizeParam;
+
+	batchSeries<T> zero(M, coef.get());
+	vector<batchSeries<T> > u(size, zero), K1(sizeVar, zero), K2(K1), K3(K1), K4(K1), v(K1), w(K1);
+	vector<batchSeries<T> > slots(graph ? graph->slots() : 0, zero);
+
+	auto gather = [&]() {
+		for (int m = 0; m < M; m++) {
+			for (int i = 0; i < size; i++)
+				u[i].set(m, members[first + m]->u[i]);
+		}
+	};
+	auto scatter = [&]() {
+		for (int m = 0; m < M; m++) {
+			for (int i = 0; i < sizeVar; i++)
+				u[i].get(m, members[first + m]->u[i]);
+		}
+	};
+
+	gather();
+	int wrapCount = 0;
+	while (tStart < tEnd + model.EPS) {
+		rhs(first, u, u, K1, slots); //k1
+		for (int i = 0; i < sizeVar; i++) {
+			K1[i] *= h;
+			v[i].axpy(u[i], K1[i], 0.5);
+		}
+
+		rhs(first, v, u, K2, slots); //k2
+		for (int i = 0; i < sizeVar; i++) {
+			K2[i] *= h;
+			v[i].axpy(u[i], K2[i], 0.5);
+		}
+
+		rhs(first, v, u, K3, slots); //k3
+		for (int i = 0; i < sizeVar; i++) {
+			K3[i] *= h;
+			v[i].add(u[i], K3[i]);
+		}
+
+		rhs(first, v, u, K4, slots); //k4
+		for (int i = 0; i < sizeVar; i++) { // u = u + (K1 + (K2 + K3) * 2 + K4) / 6
+			K4[i] *= h;
+			w[i].add(K2[i], K3[i]);
+			w[i] *= 2;
+			w[i] += K1[i];
+			w[i] += K4[i];
+			w[i] /= 6;
+			u[i] += w[i];
+		}
+
+		tStart += h;
+		if (wrapEvery > 0 && ++wrapCount % wrapEvery == 0) {
+			scatter();
+			for (int m = 0; m < M; m++)
+				members[first + m]->shrinkWrap();
+			gather();
+		}
+	}
+	scatter();
+}
+
+// правая часть для пакета: граф (setRHS) сразу для всех уравнений, иначе pFun каждого уравнения
+// через equation::rhs - ряды уравнения достаются из пакета и результат кладётся обратно
+template <typename T>
+void equationBatch<T>::rhs(int first, const vector<batchSeries<T> > &v, const vector<batchSeries<T> > &u,
+	vector<batchSeries<T> > &res, vector<batchSeries<T> > &slots) const {
+	if (graph) {
+		graph->evaluate(v, u, res, slots);
+		return;
+	}
+
+	static thread_local vector<powerSeries<T> > x, f;
+	if (x.size() != v.size() || f.size() != res.size()) {
+		const powerSeries<T> zero(coef->serieSize(), coef.get());
+		x.assign(v.size(), zero);
+		f.assign(res.size(), zero);
+	}
+	for (int m = 0; m < res[0].members(); m++) {
+		for (int i = 0; i < v.size(); i++)
+			v[i].get(m, x[i]);
+		members[first + m]->rhs(x, f);
+		for (int i = 0; i < res.size(); i++)
+			res[i].set(m, f[i]);
+	}
+}
+
+/*
+Интегрирование с делением области. Все начальные области считаются параллельно (каждая - отдельное
+уравнение), и если остаточный интервал какого-нибудь уравнения становится шире maxError, расчёт этой
+области прерывается, а сама она делится пополам по самой широкой стороне. Половины считаются заново
+с tStart в следующем круге, тоже параллельно. Области, поделённые maxDepth раз, считаются до конца
+без ограничения. После расчёта уравнения пакета - все итоговые области (box(i) - их начальные интервалы).
+*/
+template <typename T>
+void equationBatch<T>::RungeKuttaSplit(double tStart, double tEnd, double h, T maxError, int maxDepth) {
+	vector<vector<interval<T> > > pending(boxes), done;
+	vector<int> depth(pending.size(), 0), nextDepth;
+	vector<std::unique_ptr<equation<T> > > finished;
+
+	while (!pending.empty()) {
+		vector<std::unique_ptr<equation<T> > > round(pending.size());
+		vector<char> split(pending.size(), 0);
+
+		auto step = [&](int i) {
+			round[i].reset(new equation<T>(coef));
+			round[i]->initialFlow(&pending[i]);
+			round[i]->normalize();		// иначе деление области не уменьшает оценку отброшенных членов
+			round[i]->setShrinkWrap(wrapEvery);
+			if (graph)
+				round[i]->setRHS(graph);
+			if (depth[i] < maxDepth)
+				round[i]->setErrorLimit(maxError);
+			try {
+				round[i]->RungeKutta(tStart, tEnd, h);
+			}
+			catch (typename equation<T>::remainderTooLarge&) {
+				split[i] = 1;
+			}
+		};
+		if (workers)
+			workers->run(pending.size(), step);
+		else
+			for (int i = 0; i < pending.size(); i++) step(i);
+
+		vector<vector<interval<T> > > next;
+		nextDepth.clear();
+		for (int i = 0; i < pending.size(); i++) {
+			if (!split[i]) {
+				finished.push_back(std::move(round[i]));
+				done.push_back(pending[i]);
+				continue;
+			}
+
+			int widest = 0;
+			for (int v = 1; v < pending[i].size(); v++) {
+				if (pending[i][v].end() - pending[i][v].begin() > pending[i][widest].end() - pending[i][widest].begin())
+					widest = v;
+			}
+			const T lo = pending[i][widest].begin(), hi = pending[i][widest].end();
+			const T middle = splitPoint(lo, hi);
+			next.push_back(pending[i]);
+			next.back()[widest] = interval<T>(lo, middle);
+			next.push_back(pending[i]);
+			next.back()[widest] = interval<T>(middle, hi);
+			nextDepth.push_back(depth[i] + 1);
+			nextDepth.push_back(depth[i] + 1);
+		}
+		pending.swap(next);
+		depth.swap(nextDepth);
+	}
+
+	members.swap(finished);
+	boxes.swap(done);
+}
+
+// Середина [lo; hi], сдвинутая на несколько ulp так, чтобы обе половины проходили проверку
+// симметричности в equation::initialFlow. Половины всё равно покрывают [lo; hi] целиком.
+template <typename T>
+T equationBatch<T>::splitPoint(T lo, T hi) {
+	auto symmetric = [](T a, T b) { T r = (b - a) / 2; return b - r == a + r; };
+
+	const T middle = lo + (hi - lo) / 2;
+	T up = middle, down = middle;
+	for (int k = 0; k < 64; k++) {
+		if (symmetric(lo, up) && symmetric(up, hi))
+			return up;
+		if (symmetric(lo, down) && symmetric(down, hi))
+			return down;
+		up = precision<T>::nextafter(up, hi);
+		down = precision<T>::nextafter(down, lo);
+	}
+	return middle;
+}
+
+// оболочка оценок всех уравнений пакета (см. equation::range)
+template <typename T>
+vector<interval<T> > equationBatch<T>::enclosure() const {
+	vector<interval<T> > res;
+	for (int i = 0; i < size(); i++) {
+		const int n = coef->realVariable();
+		res.resize(n);
+		for (int v = 0; v < n; v++) {
+			interval<T> r = members[i]->range(v);
+			res[v] = (i == 0) ? r : interval<T>(std::min(res[v].begin(), r.begin()), std::max(res[v].end(), r.end()));
+		}
+	}
+	return res;
+}
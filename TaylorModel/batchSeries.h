@@ -0,0 +1,631 @@
+﻿/*
+Ряды всех уравнений пакета (см. equationBatch) в одном массиве, коэффициенты вперемешку:
+k-й коэффициент m-го уравнения лежит в [k * stride + m], т.е. k-е коэффициенты всех уравнений подряд
+(stride - число уравнений, дополненное нулевыми рядами до кратного batchLanes).
+Тогда каждая операция - это проход по членам ряда (или по парам расписания перемножения),
+а внутри него простой цикл по уравнениям пакета без зависимостей между итерациями,
+который компилятор векторизует (строки перемножения при сборке с AVX2 / AVX-512 - явно, см. batchRow). Таблица и расписание перемножения общие для всех уравнений.
+
+Для каждого уравнения операция повторяет powerSeries: те же произведения складываются в том же
+порядке, и погрешность оценивается теми же суммами, поэтому результат совпадает с расчётом
+через powerSeries. Элементарные функции и деление рядов считаются для каждого уравнения
+отдельно через powerSeries.
+*/
+
+#pragma once
+#include "series.h"
+#include "elementary.h"
+#include <vector>
+using std::vector;
+
+
+// рядов в группе, которую перемножение проходит целиком: для double это один вектор AVX-512 или два AVX2
+const int batchLanes = 8;
+
+// flushToZero без ветвления, чтобы цикл по уравнениям пакета векторизовался
+template <typename T>
+inline T flushLane(T &r, T ec) {
+	const T a = mabs(r);
+	const bool small = a < ec;
+	r = small ? T(0) : r;
+	return small ? a : T(0);
+}
+
+/*
+Строка расписания перемножения для группы из batchLanes рядов пакета (см. batchSeries::mul):
+r[target[q]] += c * b[j], j = index[q] (index == nullptr - j = q), и суммы для оценки округления
+sum += |p|, sum += max(|r|, |p|) - как в powerSeries::mulRows, но только для пар, которые идут в оценку:
+b[j] != 0 ? nonZero : counted не равно нулю. Остальные пары дают p = 0 и в сумму идут нули.
+y, res и все массивы групп уже сдвинуты на первый ряд группы, stride - шаг между членами ряда.
+*/
+template <typename T, typename B>
+inline void batchRow(const T *c, const T *nonZero, const T *counted, const T *y, const int *index, const int *target,
+	int size, int stride, T *res, B *sum) {
+	for (int q = 0; q < size; q++) {
+		const T *b = y + (index ? index[q] : q) * stride;
+		T *r = res + target[q] * stride;
+		for (int l = 0; l < batchLanes; l++) {
+			const T p = c[l] * b[l];
+			const T pairs = nonZero[l], rowPairs = counted[l];
+			const bool in = ((b[l] != 0) ? pairs : rowPairs) != 0;
+			const B mp = precision<T>::magnitude(p), mr = in ? precision<T>::magnitude(r[l]) : B(0);
+			sum[l] += mp;
+			sum[l] += (mr > mp) ? mr : mp;
+			r[l] += p;
+		}
+	}
+}
+
+#ifdef SERIES_SIMD
+#if defined(__AVX512F__)
+// (b != 0 ? nonZero : counted) != 0 ? |r| : 0
+inline vdouble vpairMagnitude(vdouble b, vdouble nonZero, vdouble counted, vdouble r) {
+	const vdouble zero = _mm512_setzero_pd();
+	const vdouble select = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(b, zero, _CMP_NEQ_UQ), counted, nonZero);
+	return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(select, zero, _CMP_NEQ_UQ), vabs(r));
+}
+#else
+inline vdouble vpairMagnitude(vdouble b, vdouble nonZero, vdouble counted, vdouble r) {
+	const vdouble zero = _mm256_setzero_pd();
+	const vdouble select = _mm256_blendv_pd(counted, nonZero, _mm256_cmp_pd(b, zero, _CMP_NEQ_UQ));
+	return _mm256_and_pd(_mm256_cmp_pd(select, zero, _CMP_NEQ_UQ), vabs(r));
+}
+#endif
+
+// те же операции в том же порядке для каждого ряда группы, поэтому результат совпадает со скалярным
+inline void batchRow(const double *c, const double *nonZero, const double *counted, const double *y, const int *index,
+	const int *target, int size, int stride, double *res, double *sum) {
+	const int vectors = batchLanes / vsize;
+	vdouble vc[vectors], vn[vectors], vk[vectors], vt[vectors];
+	for (int v = 0; v < vectors; v++) {
+		vc[v] = vload(c + v * vsize);
+		vn[v] = vload(nonZero + v * vsize);
+		vk[v] = vload(counted + v * vsize);
+		vt[v] = vload(sum + v * vsize);
+	}
+
+	for (int q = 0; q < size; q++) {
+		const double *b = y + (index ? index[q] : q) * stride;
+		double *r = res + target[q] * stride;
+		for (int v = 0; v < vectors; v++) {
+			const vdouble vb = vload(b + v * vsize), vr = vload(r + v * vsize);
+			const vdouble p = vmul(vc[v], vb);
+			const vdouble mp = vabs(p), mr = vpairMagnitude(vb, vn[v], vk[v], vr);
+			vt[v] = vadd(vt[v], mp);
+			vt[v] = vadd(vt[v], vmax(mr, mp));
+			vstore(r + v * vsize, vadd(vr, p));
+		}
+	}
+
+	for (int v = 0; v < vectors; v++)
+		vstore(sum + v * vsize, vt[v]);
+}
+#endif
+
+template <typename T>
+class batchSeries {
+private:
+	seriesVector<T> _series;		// k-й коэффициент m-го ряда - _series[k * _stride + m]
+	vector<interval<T> > _error;	// погрешность m-го ряда
+	int _members;
+	int _stride;					// _members, дополненное до кратного batchLanes
+	const multSerCoef *_coef;
+
+	typedef typename precision<T>::bound bound;
+	static inline bound magnitude(const T &x) { return precision<T>::magnitude(x); }
+
+	void check(const batchSeries&) const;
+	void rounding(vector<T>&, vector<T>&);
+	void finish(const vector<T>&, const vector<T>&);
+	template <typename F> void eachMember(const batchSeries&, const F&);
+
+public:
+	class notTheSameBatch {};
+
+	batchSeries() : _members(0), _stride(0), _coef(nullptr) {};
+	batchSeries(int members, const multSerCoef *coef)
+		: _error(members, interval<T>(0)), _members(members),
+		_stride((members + batchLanes - 1) / batchLanes * batchLanes), _coef(coef) {
+		_series = seriesVector<T>(coef->serieSize() * _stride, 0, seriesAllocator<T>(coef->pool()));
+	};
+
+	inline int members() const { return _members; }
+	inline const multSerCoef* table() const { return _coef; }
+	inline const T* coefficient(int k) const { return _series.data() + k * _stride; }	// k-е коэффициенты всех рядов
+	inline interval<T> error(int m) const { return _error[m]; }
+
+	void get(int, powerSeries<T>&) const;	// m-й ряд пакета
+	void set(int, const powerSeries<T>&);
+
+	// то же, что у powerSeries, для каждого ряда пакета
+	batchSeries& add(const batchSeries&, const batchSeries&);	// *this = a + b
+	batchSeries& operator+=(const batchSeries&);
+	batchSeries& operator-=(const batchSeries&);
+	batchSeries& scale(const batchSeries&, const T&);			// *this = x * a
+	batchSeries& operator*=(const T&);
+	batchSeries& operator/=(const T&);
+	batchSeries& axpy(const batchSeries&, const batchSeries&, const T&);	// *this = u + x * a
+	batchSeries& mul(const batchSeries&, const batchSeries&);	// *this = a * b
+	batchSeries& shift(const T&);								// *this = *this + c
+	batchSeries& reciprocal(const batchSeries&);				// *this = 1 / x
+	batchSeries operator/(const batchSeries&) const;
+
+	template <typename F> friend batchSeries memberwise(const batchSeries &x, const F &f) {
+		batchSeries res(x._members, x._coef);
+		res.eachMember(x, f);
+		return res;
+	}
+};
+
+template <typename T>
+void batchSeries<T>::check(const batchSeries &x) const {
+	if (x._members != _members || x._coef != _coef)
+		throw notTheSameBatch();
+}
+
+template <typename T>
+void batchSeries<T>::get(int m, powerSeries<T> &x) const {
+	if (x.table() != _coef || x.coefficients().size() != _coef->serieSize())
+		x = powerSeries<T>(_coef->serieSize(), _coef);
+	for (int k = 0; k < _coef->serieSize(); k++)
+		x.serie(k, _series[k * _stride + m]);
+	x.error(_error[m].begin(), _error[m].end());
+}
+
+template <typename T>
+void batchSeries<T>::set(int m, const powerSeries<T> &x) {
+	if (x.table() != _coef)
+		throw notTheSameBatch();
+	for (int k = 0; k < _coef->serieSize(); k++)
+		_series[k * _stride + m] = x[k];
+	_error[m] = x.error();
+}
+
+// суммы t и s для оценки погрешности округления (см. kernels.h), свои у каждого ряда пакета
+template <typename T>
+void batchSeries<T>::rounding(vector<T> &t, vector<T> &s) {
+	t.assign(_stride, 0);
+	s.assign(_stride, 0);
+}
+
+// погрешность каждого ряда: как в powerSeries, к погрешности операндов (уже в _error) добавляется округление
+template <typename T>
+void batchSeries<T>::finish(const vector<T> &t, const vector<T> &s) {
+	for (int m = 0; m < _members; m++)
+		_error[m] = _error[m] + interval<T>(-t[m], t[m])*Em<T>*E + interval<T>(-s[m], s[m])*E;
+}
+
+// ряд за рядом через powerSeries: для операций, которые в пакете не векторизуются
+template <typename T>
+template <typename F>
+void batchSeries<T>::eachMember(const batchSeries &x, const F &f) {
+	powerSeries<T> a(_coef->serieSize(), _coef), r(_coef->serieSize(), _coef);
+	for (int m = 0; m < _members; m++) {
+		x.get(m, a);
+		r = f(a);
+		set(m, r);
+	}
+}
+
+template <typename T>
+batchSeries<T>& batchSeries<T>::add(const batchSeries &a, const batchSeries &b) {
+	a.check(b);
+	static thread_local vector<T> t, s;
+	_members = a._members;
+	_stride = a._stride;
+	_coef = a._coef;
+	_series.resize(a._series.size());
+	rounding(t, s);
+
+	const int S = _stride, M = _members;
+	const T ec = Ec<T>;
+	T *pt = t.data(), *ps = s.data();
+	for (int k = 0; k < _coef->serieSize(); k++) {
+		const T *x = a._series.data() + k * S, *y = b._series.data() + k * S;
+		T *r = _series.data() + k * S;
+		for (int m = 0; m < S; m++) {
+			const T ax = mabs(x[m]), ay = mabs(y[m]);
+			pt[m] += (ax > ay) ? ax : ay;
+			r[m] = x[m] + y[m];
+			ps[m] += flushLane(r[m], ec);
+		}
+	}
+
+	_error.resize(M);
+	for (int m = 0; m < M; m++)
+		_error[m] = a._error[m] + b._error[m];
+	finish(t, s);
+	return *this;
+}
+
+template <typename T>
+batchSeries<T>& batchSeries<T>::operator+=(const batchSeries &x) {
+	return add(*this, x);
+}
+
+template <typename T>
+batchSeries<T>& batchSeries<T>::operator-=(const batchSeries &x) {
+	check(x);
+	static thread_local vector<T> t, s;
+	rounding(t, s);
+
+	const int S = _stride, M = _members;
+	const T ec = Ec<T>;
+	T *pt = t.data(), *ps = s.data();
+	for (int k = 0; k < _coef->serieSize(); k++) {
+		const T *y = x._series.data() + k * S;
+		T *r = _series.data() + k * S;
+		for (int m = 0; m < S; m++) {
+			const T ar = mabs(r[m]), ay = mabs(y[m]);
+			pt[m] += (ar > ay) ? ar : ay;
+			r[m] = r[m] - y[m];
+			ps[m] += flushLane(r[m], ec);
+		}
+	}
+
+	for (int m = 0; m < M; m++)
+		_error[m] = _error[m] - x._error[m];
+	finish(t, s);
+	return *this;
+}
+
+template <typename T>
+batchSeries<T>& batchSeries<T>::scale(const batchSeries &x, const T &a) {
+	static thread_local vector<T> t, s;
+	_members = x._members;
+	_stride = x._stride;
+	_coef = x._coef;
+	_series.resize(x._series.size());
+	rounding(t, s);
+
+	const int S = _stride, M = _members;
+	const T ec = Ec<T>;
+	T *pt = t.data(), *ps = s.data();
+	for (int k = 0; k < _coef->serieSize(); k++) {
+		const T *y = x._series.data() + k * S;
+		T *r = _series.data() + k * S;
+		for (int m = 0; m < S; m++) {
+			r[m] = y[m] * a;
+			pt[m] += mabs(r[m]);
+			ps[m] += flushLane(r[m], ec);
+		}
+	}
+
+	_error.resize(M);
+	for (int m = 0; m < M; m++)
+		_error[m] = x._error[m] * a;
+	finish(t, s);
+	return *this;
+}
+
+template <typename T>
+batchSeries<T>& batchSeries<T>::operator*=(const T &a) {
+	return scale(*this, a);
+}
+
+template <typename T>
+batchSeries<T>& batchSeries<T>::operator/=(const T &a) {
+	if (a == 0)
+		throw typename powerSeries<T>::divideByZero();
+
+	static thread_local vector<T> t, s;
+	rounding(t, s);
+
+	const int S = _stride, M = _members;
+	const T ec = Ec<T>;
+	T *pt = t.data(), *ps = s.data();
+	for (int k = 0; k < _coef->serieSize(); k++) {
+		T *r = _series.data() + k * S;
+		for (int m = 0; m < S; m++) {
+			r[m] = r[m] / a;
+			pt[m] += mabs(r[m]);
+			ps[m] += flushLane(r[m], ec);
+		}
+	}
+
+	for (int m = 0; m < M; m++)
+		_error[m] = _error[m] / a;
+	finish(t, s);
+	return *this;
+}
+
+// как powerSeries::axpy: tx, sx - для x * a, t, s - для суммы
+template <typename T>
+batchSeries<T>& batchSeries<T>::axpy(const batchSeries &u, const batchSeries &x, const T &a) {
+	u.check(x);
+	static thread_local vector<T> tx, sx, t, s;
+	_members = u._members;
+	_stride = u._stride;
+	_coef = u._coef;
+	_series.resize(u._series.size());
+	rounding(tx, sx);
+	rounding(t, s);
+
+	const int S = _stride, M = _members;
+	const T ec = Ec<T>;
+	T *ptx = tx.data(), *psx = sx.data(), *pt = t.data(), *ps = s.data();
+	for (int k = 0; k < _coef->serieSize(); k++) {
+		const T *pu = u._series.data() + k * S, *px = x._series.data() + k * S;
+		T *r = _series.data() + k * S;
+		for (int m = 0; m < S; m++) {
+			T y = px[m] * a;
+			ptx[m] += mabs(y);
+			psx[m] += flushLane(y, ec);
+
+			const T au = mabs(pu[m]), ay = mabs(y);
+			pt[m] += (au > ay) ? au : ay;
+			r[m] = pu[m] + y;
+			ps[m] += flushLane(r[m], ec);
+		}
+	}
+
+	_error.resize(M);
+	for (int m = 0; m < M; m++) {
+		interval<T> xError = x._error[m] * a + interval<T>(-tx[m], tx[m])*Em<T>*E + interval<T>(-sx[m], sx[m])*E;
+		_error[m] = u._error[m] + xError;
+	}
+	finish(t, s);
+	return *this;
+}
+
+template <typename T>
+batchSeries<T>& batchSeries<T>::shift(const T &c) {
+	for (int m = 0; m < _members; m++) {
+		const T c0 = _series[m] + c;		// член нулевой степени - первый в ряде
+		_series[m] = c0;
+		_error[m] += interval<T>(-mabs(c0), mabs(c0))*Em<T>*E;
+	}
+	return *this;
+}
+
+/*
+Перемножение по расписанию multSerCoef: для каждой пары (i, j) расписания цикл по уравнениям пакета
+a[i][m] * b[j][m] складывается в res[target][m]. Уравнения идут группами по batchLanes, каждая группа
+проходит всё расписание, а её суммы для оценки округления лежат в локальном массиве.
+Для ряда пакета с нулевым a[i] произведение - точный ноль и коэффициент не меняет, а в сумму для оценки
+округления такие пары не идут, как и в powerSeries::mul. Там же для каждого ряда выбирается разреженное
+перемножение (по ненулевым парам), здесь для таких рядов в оценку идут только ненулевые пары,
+а J считается перебором ненулевых пар - получаются те же оценки.
+Без расписания (очень большие ряды) ряды перемножаются по одному через powerSeries.
+*/
+template <typename T>
+batchSeries<T>& batchSeries<T>::mul(const batchSeries &a, const batchSeries &b) {
+	a.check(b);
+	if (this == &a || this == &b) {
+		batchSeries res(a._members, a._coef);
+		res.mul(a, b);
+		return *this = std::move(res);
+	}
+
+	_members = a._members;
+	_stride = a._stride;
+	_coef = a._coef;
+	const int M = _members, S = _stride, n = _coef->serieSize(), order = _coef->order();
+	if (!_coef->hasMultSchedule()) {
+		_series.assign(a._series.size(), 0);
+		_error.resize(M);
+		powerSeries<T> x(n, _coef), y(n, _coef), r(n, _coef);
+		for (int m = 0; m < M; m++) {
+			a.get(m, x);
+			b.get(m, y);
+			set(m, r.mul(x, y));
+		}
+		return *this;
+	}
+
+	_series.assign(a._series.size(), 0);
+	_error.assign(M, interval<T>(0));
+	const T *x = a._series.data(), *y = b._series.data();
+	T *res = _series.data();
+
+	// выбор разреженного перемножения для каждого ряда - как в powerSeries::mul
+	static thread_local vector<long long> rows, nz1, nz2;
+	static thread_local vector<T> dense;	// 1 - ряд перемножается по расписанию, 0 - по ненулевым парам
+	rows.assign(S, 0);
+	nz1.assign(S, 0);
+	nz2.assign(S, 0);
+	dense.resize(S);
+	for (int i = 0; i < n; i++) {
+		const int length = _coef->multStart(i + 1) - _coef->multStart(i);
+		for (int m = 0; m < S; m++) {
+			if (x[i * S + m] != 0) {
+				nz1[m]++;
+				rows[m] += length;
+			}
+			if (y[i * S + m] != 0)
+				nz2[m]++;
+		}
+	}
+	for (int m = 0; m < S; m++)
+		dense[m] = (nz1[m] * nz2[m] * 2 < rows[m]) ? 0 : 1;
+
+	// пара идёт в оценку, если c != 0 и ряд перемножается по расписанию (counted[l] != 0)
+	// или c != 0 и b[j] != 0 (nonZero[l] != 0), см. batchRow
+	static thread_local vector<bound> t;
+	t.resize(S);
+	const int *multIndex = _coef->multIndex();
+	const int *multTarget = _coef->multTarget();
+	static thread_local vector<int> nzGroup, rowIndex, rowTarget;
+	for (int first = 0; first < S; first += batchLanes) {
+		bound sum[batchLanes] = {};
+		T counted[batchLanes], nonZero[batchLanes];
+
+		// все ряды группы разреженные - вместо строк расписания только пары с ненулевым членом b
+		// хотя бы у одного ряда группы; лишние пары дают нулевые добавки
+		bool sparse = true;
+		for (int l = 0; l < batchLanes && first + l < M; l++)
+			sparse = sparse && dense[first + l] == 0;
+		if (sparse) {
+			nzGroup.clear();
+			for (int j = 0; j < n; j++) {
+				bool any = false;
+				for (int l = 0; l < batchLanes; l++)
+					any = any || y[j * S + first + l] != 0;
+				if (any)
+					nzGroup.push_back(j);
+			}
+		}
+
+		for (int i = 0; i < n; i++) {
+			const T *c = x + i * S + first;
+			bool any = false;
+			for (int l = 0; l < batchLanes; l++) {
+				nonZero[l] = (c[l] != 0) ? 1 : 0;
+				counted[l] = (c[l] != 0) ? dense[first + l] : 0;
+				any = any || c[l] != 0;
+			}
+			if (!any)
+				continue;
+
+			if (sparse) {
+				rowIndex.clear();
+				rowTarget.clear();
+				for (int j : nzGroup) {
+					const int index = _coef->getMultIndex(i, j);
+					if (index != -1) {
+						rowIndex.push_back(j);
+						rowTarget.push_back(index);
+					}
+				}
+				batchRow(c, nonZero, counted, y + first, rowIndex.data(), rowTarget.data(), rowIndex.size(), S, res + first, sum);
+				continue;
+			}
+
+			const int start = _coef->multStart(i);
+			batchRow(c, nonZero, counted, y + first, _coef->graded() ? nullptr : multIndex + start, multTarget + start,
+				_coef->multStart(i + 1) - start, S, res + first, sum);
+		}
+		for (int l = 0; l < batchLanes; l++)
+			t[first + l] = sum[l];
+	}
+
+	// J: Js[d * S + m] - сумма |b[j]| m-го ряда по членам степени не ниже d
+	// нужны только рядам, которые перемножаются по расписанию
+	static thread_local vector<bound> Js;
+	Js.assign((order + 2) * S, 0);
+	bool anyDense = false;
+	for (int m = 0; m < M; m++)
+		anyDense = anyDense || dense[m] != 0;
+	if (anyDense && _coef->graded()) {
+		static thread_local vector<bound> J;
+		for (int d = order; d >= 1; d--) {
+			J.assign(S, 0);
+			for (int j = _coef->orderStart(d); j < _coef->orderStart(d + 1); j++) {
+				for (int m = 0; m < S; m++)
+					J[m] += magnitude(y[j * S + m]);
+			}
+			for (int m = 0; m < S; m++)
+				Js[d * S + m] = Js[(d + 1) * S + m] + J[m];
+		}
+	}
+	else if (anyDense) {
+		for (int j = 0; j < n; j++) {
+			const T *b = y + j * S;
+			bool any = false;
+			for (int m = 0; m < S; m++)
+				any = any || b[m] != 0;
+			if (!any)
+				continue;	// нулевые члены ничего не добавляют, и в powerSeries::mul их тоже нет
+
+			const int degree = _coef->getMultOrder(j);
+			for (int d = 1; d <= degree; d++) {
+				bound *J = Js.data() + d * S;
+				for (int m = 0; m < S; m++)
+					J[m] += magnitude(b[m]);
+			}
+		}
+	}
+	const bound grow = 1 + (n + 2) * std::numeric_limits<bound>::epsilon();
+
+	// остальное - интервальные оценки, для каждого ряда отдельно и в том же порядке, что в powerSeries::mul
+	static thread_local vector<int> nz;
+	static thread_local vector<interval<T> > Jd;	// Jd[d] + погрешность b
+	for (int m = 0; m < M; m++) {
+		nz.clear();
+		for (int j = 0; j < n; j++) {
+			if (y[j * S + m] != 0)
+				nz.push_back(j);
+		}
+
+		if (dense[m] != 0) {
+			Jd.resize(order + 2);
+			for (int d = 0; d < order + 2; d++) {
+				const bound J = Js[d * S + m] * grow;
+				Jd[d] = interval<T>(T(-J), T(J)) + b._error[m];
+			}
+			for (int i = 0; i < n; i++) {
+				const T c = x[i * S + m];
+				if (c != 0)
+					_error[m] += interval<T>(-mabs(c), mabs(c)) * Jd[_coef->multOverflow(i)];
+			}
+		}
+		else {
+			for (int i = 0; i < n; i++) {
+				const T c = x[i * S + m];
+				if (c == 0)
+					continue;
+				interval<T> J = interval<T>(0, 0);
+				for (int j : nz) {
+					const T d = y[j * S + m];
+					if (_coef->getMultOrder(i) + _coef->getMultOrder(j) > order)
+						J += interval<T>(-mabs(d), mabs(d));
+				}
+				_error[m] += interval<T>(-mabs(c), mabs(c)) * (J + b._error[m]);
+			}
+		}
+
+		interval<T> temp(0, 0);
+		for (int j : nz)
+			temp += interval<T>(-mabs(y[j * S + m]), mabs(y[j * S + m]));
+		_error[m] += a._error[m] * (b._error[m] + temp);
+
+		T s = 0;
+		for (int k = 0; k < n; k++) {
+			T &r = res[k * S + m];
+			if (mabs(r) < Ec<T>) {
+				s += mabs(r);
+				r = 0;
+			}
+		}
+		_error[m] += interval<T>(T(-t[m]), T(t[m]))*E*Em<T> + interval<T>(-s, s)*E;
+	}
+	return *this;
+}
+
+template <typename T>
+batchSeries<T>& batchSeries<T>::reciprocal(const batchSeries &x) {
+	return *this = memberwise(x, [](const powerSeries<T> &a) { return ::reciprocal(a); });
+}
+
+template <typename T>
+batchSeries<T> batchSeries<T>::operator/(const batchSeries &x) const {
+	check(x);
+	batchSeries res(_members, _coef);
+	powerSeries<T> a(_coef->serieSize(), _coef), b(_coef->serieSize(), _coef);
+	for (int m = 0; m < _members; m++) {
+		get(m, a);
+		x.get(m, b);
+		res.set(m, a / b);
+	}
+	return res;
+}
+
+template <typename T>
+batchSeries<T> exp(const batchSeries<T> &x) {
+	return memberwise(x, [](const powerSeries<T> &a) { return exp(a); });
+}
+
+template <typename T>
+batchSeries<T> sin(const batchSeries<T> &x) {
+	return memberwise(x, [](const powerSeries<T> &a) { return sin(a); });
+}
+
+template <typename T>
+batchSeries<T> cos(const batchSeries<T> &x) {
+	return memberwise(x, [](const powerSeries<T> &a) { return cos(a); });
+}
+
+template <typename T>
+batchSeries<T> sqrt(const batchSeries<T> &x) {
+	return memberwise(x, [](const powerSeries<T> &a) { return sqrt(a); });
+}
@@ -1,18 +1,62 @@
 ﻿#include "coefficients.h"
+#include <cstdio>
+#include <fstream>
+#include <random>
 
-multSerCoef::multSerCoef(int nvar, int param, int order) {
+multSerCoef::multSerCoef(int nvar, int param, int order, bool graded) {
+	setShape(nvar, param, order, graded);
+	buildTables();
+}
+
+// Таблицы берутся из файла filename, если он записан для тех же nvar + param, order и graded,
+// иначе строятся заново и записываются в этот файл (ошибка записи не мешает работе).
+multSerCoef::multSerCoef(int nvar, int param, int order, bool graded, const std::string &filename) {
+	setShape(nvar, param, order, graded);
+	if (load(filename))
+		return;
+
+	buildTables();
+	save(filename);
+}
+
+void multSerCoef::setShape(int nvar, int param, int order, bool graded) {
 	_order = order;
+	_graded = graded;
+	_pool = std::make_shared<blockPool>();
 	_realParameter = param;
 	_realVariable = nvar;
 	nvar += param;
 	_variable = (nvar % 2) ? nvar + 1 : nvar;
-	_seriesSize = findSeriesSize(_order + _variable, _variable, _order);
+	_seriesSize = findSeriesSize(_order + _variable, _variable, _order) + 0.5;	// 189.99999... -> 190
+}
 
+void multSerCoef::buildTables() {
 	C.resize(2);
 	D.resize(2);
 
 	findC();
 	findD();
+	if (_graded)
+		sortByOrder();
+	bindTables();		// расписание строится через getMultIndex, т.е. по уже готовым C и D
+
+	findMultSchedule();
+	bindTables();
+}
+
+void multSerCoef::bindTables() {
+	_table[tableC1] = C[0];
+	_table[tableC2] = C[1];
+	_table[tableD1] = D[0];
+	_table[tableD2] = D[1];
+	_table[tableSumOrder] = _sumOrder;
+	_table[tableOrders] = orderTable;
+	_table[tableLayout] = _layout;
+	_table[tableOrderStart] = _orderStart;
+	_table[tableMultStart] = _multStart;
+	_table[tableMultIndex] = _multIndex;
+	_table[tableMultTarget] = _multTarget;
+	_table[tableMultOverflow] = _multOverflow;
 }
 
 double multSerCoef::findSeriesSize(double np, double n, double p) {
@@ -26,149 +70,480 @@ double multSerCoef::findSeriesSize(double np, double n, double p) {
 Реализация алгоритма, рассмотренного в статье
 Algorithms for higher order automatic differentiation in many variables with applications to beam physics
 Martin Berz
+
+Члены ряда сгруппированы по c2, группы идут по возрастанию (степень, c2) второй половины члена,
+внутри группы члены идут по возрастанию (степень, c1) первой половины. Поэтому достаточно
+один раз отсортировать половины членов, а сами члены получить как пары половин
+с суммарной степенью не больше _order, не перебирая все (_order + 1)^_variable строк.
 */
 void multSerCoef::findC() {
-	vector<int> indices(_variable, 0);
-	vector<int> alphabet(_order + 1);
-	for (int i = 0; i <= _order; i++)
-		alphabet[i] = i;
-	const int stopIndex = alphabet.size() - 1;
+	vector<halfMonomial> half;
+	findHalfMonomials(half);
+	std::sort(half.begin(), half.end(), [](const halfMonomial &a, const halfMonomial &b) {
+		return (a._sumOrder == b._sumOrder) ? a._code < b._code : a._sumOrder < b._sumOrder;
+	});
 
+	C[0].reserve(_seriesSize);
+	C[1].reserve(_seriesSize);
+	_sumOrder.reserve(_seriesSize);
+	orderTable.reserve(_seriesSize * _variable);
 
-	int count = 0;  // счётчик найденных элементов ряда
-	vector<int> powArray(_variable / 2); // 1 order+1 (order+1)^2 ... (order+1)^(variable/2)
-	findPowArray(powArray);
+	for (const halfMonomial &h2 : half) {
+		for (const halfMonomial &h1 : half) {
+			if (h1._sumOrder + h2._sumOrder > _order)
+				break;
 
-	vector<sortTableCoef> sortVec;
-	sortTableCoef elem(0, 0, 0);
-	elem._order.resize(_variable);
+			C[0].push_back(h1._code);
+			C[1].push_back(h2._code);
+			_sumOrder.push_back(h1._sumOrder + h2._sumOrder);
 
-	bool flag = true;
-	while (flag) {
-		if (count >= _seriesSize) break;
+			orderTable.insert(orderTable.end(), h1._order.begin(), h1._order.end());
+			orderTable.insert(orderTable.end(), h2._order.begin(), h2._order.end());
+		}
+	}
+}
 
-		elem.setToZero();
-		for (int i = 0; i < _variable / 2; i++) {
-			elem._c1 += alphabet[indices[i]] * powArray[i]; // вычисление коэф. по формуле
-			elem._c2 += alphabet[indices[i + _variable / 2]] * powArray[i];
-			elem._sumOrder += alphabet[indices[i]] + alphabet[indices[i + _variable / 2]];
+// все строки степеней длины _variable / 2 с суммой не больше _order
+void multSerCoef::findHalfMonomials(vector<halfMonomial> &half) {
+	const int size = _variable / 2;
+	vector<int> powArray(size);		// 1 order+1 (order+1)^2 ... (order+1)^(variable/2 - 1)
+	powArray[0] = 1;
+	for (int i = 1; i < size; i++)
+		powArray[i] = powArray[i - 1] * (_order + 1);
 
-			elem._order[i] = alphabet[indices[i]];
-			elem._order[i + _variable / 2] = alphabet[indices[i + _variable / 2]];
-		}
+	halfMonomial elem;
+	elem._code = elem._sumOrder = 0;
+	elem._order.assign(size, 0);
 
-		if (elem._sumOrder <= _order) {
-			sortVec.push_back(elem);
-			count++;
-		}
+	while (true) {
+		half.push_back(elem);
 
-		// перебор строк длины _variable для алфавита = {0.._order}
-		int pos = _variable;
-		while (indices[--pos] == stopIndex) {   // если на данной позиции перебраны все символы из алфавита
-			if (pos == 0) {
-				flag = false;                   // заканчиваем работу, т.к. перебраны все варианты
-				break;
-			}
-			indices[pos] = 0;
+		// следующая строка: увеличиваем первую позицию, которую можно увеличить
+		// не выходя за _order, а все позиции перед ней обнуляем
+		int pos = 0;
+		while (pos < size && elem._sumOrder == _order) {
+			elem._sumOrder -= elem._order[pos];
+			elem._code -= elem._order[pos] * powArray[pos];
+			elem._order[pos++] = 0;
 		}
-		++indices[pos];                         // увеличиваем индекс левого соседа
+		if (pos == size)
+			break;
 
+		elem._order[pos]++;
+		elem._sumOrder++;
+		elem._code += powArray[pos];
 	}
+}
 
+// D[0][c1] - номер первого члена с таким c1 плюс 1, D[1][c2] - номер первого члена с таким c2,
+// 0 - если такого члена нет. Заполняется одним обратным проходом по C.
+void multSerCoef::findD() {
+	int size = 1;
+	for (int i = 0; i < _variable / 2; i++)
+		size *= _order + 1;
 
-	std::stable_sort(sortVec.begin(), sortVec.end(), sortCFirstStep);
-	sortCSecondStep(sortVec);	
+	D[0].assign(size, 0);
+	D[1].assign(size, 0);
+	for (int i = _seriesSize - 1; i >= 0; i--) {
+		D[0][C[0][i]] = i + 1;
+		D[1][C[1][i]] = i;
+	}
 }
 
-void multSerCoef::findPowArray(vector<int> &arr) {
-	arr[0] = 1;
-	for (int i = 1; i < arr.size(); i++) {
-		arr[i] = arr[i - 1] * (_order + 1);
+// Упорядочивание членов ряда по степени (внутри одной степени порядок Берца сохраняется).
+// Тогда для i-го члена степени d все допустимые множители - это префикс ряда
+// со степенями не выше _order - d, а всё остальное подряд уходит в погрешность J.
+// Таблица D остаётся построенной по порядку Берца, номер пересчитывается через _layout.
+void multSerCoef::sortByOrder() {
+	vector<int> berzIndex(_seriesSize);		// berzIndex[новый номер] = номер по Берцу
+	for (int i = 0; i < _seriesSize; i++)
+		berzIndex[i] = i;
+	std::stable_sort(berzIndex.begin(), berzIndex.end(), [&](int a, int b) { return _sumOrder[a] < _sumOrder[b]; });
+
+	vector<vector<int> > sortedC(2, vector<int>(_seriesSize));
+	vector<int> sortedTable(_seriesSize * _variable);
+	vector<int> sortedSum(_seriesSize);
+	_layout.resize(_seriesSize);
+	for (int i = 0; i < _seriesSize; i++) {
+		_layout[berzIndex[i]] = i;
+		sortedC[0][i] = C[0][berzIndex[i]];
+		sortedC[1][i] = C[1][berzIndex[i]];
+		sortedSum[i] = _sumOrder[berzIndex[i]];
+		std::copy(orderTable.begin() + berzIndex[i] * _variable, orderTable.begin() + (berzIndex[i] + 1) * _variable,
+			sortedTable.begin() + i * _variable);
 	}
-}
+	C.swap(sortedC);
+	orderTable.swap(sortedTable);
+	_sumOrder.swap(sortedSum);
 
-// устойчивая(!) сортировка в первую очередь по c2,
-// затем по степени элемента ряда,
-// затем в зависимости от c1
-bool multSerCoef::sortCFirstStep(const sortTableCoef &a, const sortTableCoef &b) {
-	return (a._c2 == b._c2) ?
-		((a._sumOrder == b._sumOrder) ? a._c1 < b._c1 : a._sumOrder < b._sumOrder)
-		: ((a._sumOrder == b._sumOrder) ? a._c2 < b._c2 : a._sumOrder < b._sumOrder);
+	_orderStart.assign(_order + 2, 0);
+	for (int i = 0; i < _seriesSize; i++)
+		_orderStart[_sumOrder[i] + 1]++;
+	for (int d = 1; d <= _order + 1; d++)
+		_orderStart[d] += _orderStart[d - 1];
 }
 
-void multSerCoef::sortCSecondStep(vector<sortTableCoef> &v) {
-	int k = 0;
-	int j;
+// Расписание строится один раз, чтобы при перемножении рядов не вызывать getMultIndex
+// для каждой пары и не пропускать пары, выходящие за порядок.
+// Для больших рядов таблица не помещается в память, тогда перемножение идёт через getMultIndex.
+void multSerCoef::findMultSchedule() {
+	const long long maxScheduleSize = 1 << 24;
 
-	while (!v.empty()) {
-		k = v[0]._c2;
+	vector<long long> countByOrder(_order + 1, 0);	// сколько членов имеют степень не больше k
+	for (int i = 0; i < _seriesSize; i++)
+		countByOrder[_sumOrder[i]]++;
+	for (int k = 1; k <= _order; k++)
+		countByOrder[k] += countByOrder[k - 1];
 
-		for (j = 0; j < v.size(); j++) {
-			if (v[j]._c2 == k) {
-				C[0].push_back(v[j]._c1);
-				C[1].push_back(v[j]._c2);
-				_sumOrder.push_back(v[j]._sumOrder);
-				orderTable.push_back(v[j]._order);
-			}
+	long long size = 0;
+	for (int i = 0; i < _seriesSize; i++)
+		size += countByOrder[_order - _sumOrder[i]];
+	if (size > maxScheduleSize)
+		return;
+
+	_multStart.reserve(_seriesSize + 1);
+	_multOverflow.reserve(_seriesSize);
+	_multTarget.reserve(size);
+	vector<int> groupStart;		// члены с одинаковым c2 лежат в [groupStart[g]; groupStart[g + 1])
+	if (!_graded) {
+		_multIndex.reserve(size);
+		for (int j = 0; j < _seriesSize; j++) {
+			if (j == 0 || C[1][j] != C[1][j - 1])
+				groupStart.push_back(j);
 		}
-		removeByValue(v, k);    // удалить все элементы, где _c2 = k
+		groupStart.push_back(_seriesSize);
 	}
-}
 
-void multSerCoef::removeByValue(vector<sortTableCoef> &v, int val) {
-	v.erase(std::remove_if(v.begin(), v.end(), [&](sortTableCoef &stc){ return stc._c2 == val; }), v.end());
-}
+	for (int i = 0; i < _seriesSize; i++) {
+		_multStart.push_back(_multTarget.size());
+		_multOverflow.push_back(_order - _sumOrder[i] + 1);
 
-void multSerCoef::findD() {
-	int size = pow(_order + 1, _variable / 2);
-	for (int i = 0; i < size; i++) {
-		D[0].push_back(findDElementC1(i));
-		D[1].push_back(findDElementC2(i));
+		if (_graded) {
+			for (int j = 0; j < _orderStart[_multOverflow[i]]; j++)
+				_multTarget.push_back(getMultIndex(i, j));
+			continue;
+		}
+
+		// группы с одинаковым c2 идут по возрастанию степени первого члена,
+		// внутри группы степень тоже не убывает, поэтому допустимые j - начала групп
+		for (int g = 0; g + 1 < (int)groupStart.size() && _sumOrder[groupStart[g]] < _multOverflow[i]; g++) {
+			for (int j = groupStart[g]; j < groupStart[g + 1] && _sumOrder[j] < _multOverflow[i]; j++) {
+				_multIndex.push_back(j);
+				_multTarget.push_back(getMultIndex(i, j));
+			}
+		}
 	}
+	_multStart.push_back(_multTarget.size());
 }
 
-int multSerCoef::findDElementC1(int elem) {
-	for (int i = 0; i < _seriesSize; i++) {
-		if (C[0][i] == elem)
-			return i + 1;
+// Перемножение одного ряда в нескольких потоках (только если есть расписание findMultSchedule).
+// Разбиение на блоки не зависит от числа потоков, поэтому и результат от него не зависит.
+void multSerCoef::setThreads(int threads) {
+	if (threads > 1 && hasMultSchedule()) {
+		if (_gatherStart.empty())
+			findGatherSchedule();
+		_workers = std::make_shared<threadPool>(threads);
 	}
-	return 0;
+	else
+		_workers.reset();
 }
 
-int multSerCoef::findDElementC2(int elem) {
+void multSerCoef::findGatherSchedule() {
+	const int blocks = 64;
+	const tableView multStart = _table[tableMultStart];
+	const tableView multIndex = _table[tableMultIndex];
+	const tableView multTarget = _table[tableMultTarget];
+	const int size = multTarget.size();
+
+	_gatherStart.assign(_seriesSize + 1, 0);
+	for (int k = 0; k < size; k++)
+		_gatherStart[multTarget[k] + 1]++;
+	for (int k = 1; k <= _seriesSize; k++)
+		_gatherStart[k] += _gatherStart[k - 1];
+
+	_gatherRow.resize(size);
+	_gatherCol.resize(size);
+	vector<int> pos(_gatherStart.begin(), _gatherStart.end() - 1);
 	for (int i = 0; i < _seriesSize; i++) {
-		if (C[1][i] == elem)
-			return i;
+		for (int k = multStart[i]; k < multStart[i + 1]; k++) {
+			int q = pos[multTarget[k]]++;
+			_gatherRow[q] = i;
+			_gatherCol[q] = (_graded) ? k - multStart[i] : multIndex[k];
+		}
+	}
+
+	_gatherBlock.assign(1, 0);
+	for (int k = 1; k < _seriesSize; k++) {
+		if ((long long)_gatherStart[k] * blocks >= (long long)size * (int)_gatherBlock.size())
+			_gatherBlock.push_back(k);
 	}
-	return 0;
+	_gatherBlock.push_back(_seriesSize);
 }
 
 int multSerCoef::getMultIndex(int index1, int index2) const {
 	if (getMultOrder(index1) + getMultOrder(index2) > _order)
 		return -1;
 
-	int c1 = C[0][index1] + C[0][index2];
-	int c2 = C[1][index1] + C[1][index2];
-	return D[0][c1] + D[1][c2] - 1;
+	int c1 = _table[tableC1][index1] + _table[tableC1][index2];
+	int c2 = _table[tableC2][index1] + _table[tableC2][index2];
+	int index = _table[tableD1][c1] + _table[tableD2][c2] - 1;
+	return (_graded) ? _table[tableLayout][index] : index;
 }
 
 int multSerCoef::getMultOrder(int index) const {
-	return _sumOrder[index];
+	return _table[tableSumOrder][index];
+}
+
+// номер члена первой степени переменной var, -1 - если порядок равен 0
+int multSerCoef::getVarIndex(int var) const {
+	for (int i = 0; i < _seriesSize; i++) {
+		if (getMultOrder(i) == 1 && getVarOrder(i, var) == 1)
+			return i;
+	}
+	return -1;
 }
 
 void multSerCoef::printTableC() const {
 	std::cout << "I\t  C1\t|  C2\t|  sumOrder\t|  order" << std::endl;
-	for (int i = 0; i < C[0].size(); i++) {
-		std::cout << i + 1 << "\t  " << C[0][i] << "\t|  " << C[1][i] << "\t|  " << _sumOrder[i] << "\t|  ";
-		for (int e : orderTable[i])
-			std::cout << e << "  ";
+	for (int i = 0; i < _table[tableC1].size(); i++) {
+		std::cout << i + 1 << "\t  " << _table[tableC1][i] << "\t|  " << _table[tableC2][i] << "\t|  " << getMultOrder(i) << "\t|  ";
+		for (int k = 0; k < _variable; k++)
+			std::cout << getVarOrder(i, k) << "  ";
 		std::cout << std::endl;
 	}
 }
 
 void multSerCoef::printTableD() const {
 	std::cout << "I\t  D1\t|  D2" << std::endl;
-	for (int i = 0; i < D[0].size(); i++) {
-		std::cout << i  << "\t  " << D[0][i] << "\t|  " << D[1][i] << std::endl;
+	for (int i = 0; i < _table[tableD1].size(); i++) {
+		std::cout << i  << "\t  " << _table[tableD1][i] << "\t|  " << _table[tableD2][i] << std::endl;
+	}
+}
+
+
+////////////////////////////////////////////////
+//	файл таблиц
+////////////////////////////////////////////////
+
+/*
+Формат файла: заголовок tableFileHeader, затем массивы _table в порядке tableName,
+каждый с границы в tableFileAlign байт (чтобы после отображения в память массивы были выровнены).
+Числа хранятся как есть, поэтому файл читается только на машине с тем же порядком байт
+и размером int - это проверяется по полям endian и intSize.
+При изменении формата или построения таблиц нужно увеличить tableFileVersion.
+Поле checksum - контрольная сумма всех массивов; кроме неё при загрузке проверяется,
+что все номера в таблицах не выходят за ряд (см. multSerCoef::checkTables).
+*/
+namespace {
+	const char tableFileMagic[8] = { 'T', 'M', 'C', 'O', 'E', 'F', 0, 0 };
+	const int tableFileVersion = 2;
+	const int tableFileEndian = 0x01020304;
+	const int tableFileAlign = 64;
+
+	struct tableFileHeader {
+		char magic[8];
+		int version;
+		int endian;
+		int intSize;
+		int variable;		// nvar + param, доведённое до чётного
+		int order;
+		int graded;
+		int seriesSize;
+		int tables;
+		unsigned long long checksum;	// FNV-1a по длинам и значениям массивов
+		long long offset[16];	// смещение массива от начала файла
+		long long size[16];		// длина массива в int
+	};
+
+	unsigned long long tableChecksum(const tableView *table, int count) {
+		unsigned long long hash = 14695981039346656037ULL;
+		for (int t = 0; t < count; t++) {
+			hash = (hash ^ (unsigned)table[t].size()) * 1099511628211ULL;
+			for (int i = 0; i < table[t].size(); i++)
+				hash = (hash ^ (unsigned)table[t][i]) * 1099511628211ULL;
+		}
+		return hash;
+	}
+}
+
+bool multSerCoef::save(const std::string &filename) const {
+	static_assert(tableCount <= 16, "tableFileHeader holds at most 16 tables");
+
+	tableFileHeader header = {};
+	std::copy(tableFileMagic, tableFileMagic + 8, header.magic);
+	header.version = tableFileVersion;
+	header.endian = tableFileEndian;
+	header.intSize = sizeof(int);
+	header.variable = _variable;
+	header.order = _order;
+	header.graded = _graded;
+	header.seriesSize = _seriesSize;
+	header.tables = tableCount;
+	header.checksum = tableChecksum(_table, tableCount);
+
+	long long offset = sizeof(header);
+	for (int t = 0; t < tableCount; t++) {
+		offset = (offset + tableFileAlign - 1) / tableFileAlign * tableFileAlign;
+		header.offset[t] = offset;
+		header.size[t] = _table[t].size();
+		offset += header.size[t] * sizeof(int);
+	}
+
+	// пишем во временный файл и переименовываем, чтобы другие процессы
+	// никогда не увидели файл, записанный наполовину
+	std::string temp = filename + ".tmp" + std::to_string(std::random_device()());
+	{
+		std::ofstream out(temp, std::ios::binary);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (int t = 0; t < tableCount; t++) {
+			while (out.tellp() < header.offset[t])
+				out.put(0);
+			out.write(reinterpret_cast<const char*>(_table[t].data()), header.size[t] * sizeof(int));
+		}
+		if (!out.good()) {
+			out.close();
+			std::remove(temp.c_str());
+			return false;
+		}
+	}
+
+	if (std::rename(temp.c_str(), filename.c_str()) != 0) {
+		std::remove(filename.c_str());		// под Windows rename не заменяет существующий файл
+		if (std::rename(temp.c_str(), filename.c_str()) != 0) {
+			std::remove(temp.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+// false, если файла нет, он записан для других параметров, другой версией или на другой машине,
+// либо повреждён (не сошлась контрольная сумма или номера в таблицах выходят за ряд)
+bool multSerCoef::load(const std::string &filename) {
+	std::shared_ptr<mappedFile> file = std::make_shared<mappedFile>(filename);
+	if (!file->isOpen() || file->size() < sizeof(tableFileHeader))
+		return false;
+
+	tableFileHeader header;
+	std::copy(file->data(), file->data() + sizeof(header), reinterpret_cast<char*>(&header));
+	if (!std::equal(tableFileMagic, tableFileMagic + 8, header.magic) || header.version != tableFileVersion
+			|| header.endian != tableFileEndian || header.intSize != sizeof(int) || header.tables != tableCount)
+		return false;
+	if (header.variable != _variable || header.order != _order || header.graded != _graded
+			|| header.seriesSize != _seriesSize)
+		return false;
+
+	for (int t = 0; t < tableCount; t++) {
+		if (header.offset[t] % tableFileAlign != 0 || header.size[t] < 0
+				|| header.offset[t] + header.size[t] * (long long)sizeof(int) > (long long)file->size())
+			return false;
+	}
+
+	const long long n = _seriesSize;
+	long long dSize = 1;
+	for (int i = 0; i < _variable / 2; i++)
+		dSize *= _order + 1;
+	const bool schedule = header.size[tableMultStart] != 0;
+	const long long expected[tableCount] = { n, n, dSize, dSize, n, n * _variable,
+		_graded ? n : 0, _graded ? _order + 2 : 0,
+		schedule ? n + 1 : 0, header.size[tableMultIndex], header.size[tableMultTarget], schedule ? n : 0 };
+	for (int t = 0; t < tableCount; t++) {
+		if (header.size[t] != expected[t])
+			return false;
+	}
+	if (header.size[tableMultIndex] != (_graded ? 0 : header.size[tableMultTarget]))
+		return false;
+
+	for (int t = 0; t < tableCount; t++)
+		_table[t] = tableView(reinterpret_cast<const int*>(file->data() + header.offset[t]), header.size[t]);
+	if (tableChecksum(_table, tableCount) != header.checksum || !checkTables()) {
+		for (int t = 0; t < tableCount; t++)
+			_table[t] = tableView();
+		return false;
+	}
+
+	_file = file;
+	return true;
+}
+
+// Проверка загруженных таблиц: все номера, по которым потом читаются и пишутся ряды,
+// лежат в [0; _seriesSize). Для C и D проверяется больше - что каждый член находится
+// по своим c1, c2 на своём месте, тогда и getMultIndex для любой пары с суммарной
+// степенью не выше _order попадает в ряд (такое произведение - тоже член ряда).
+bool multSerCoef::checkTables() const {
+	const int n = _seriesSize;
+	const int size = _variable / 2;
+	const tableView &c1 = _table[tableC1], &c2 = _table[tableC2], &d1 = _table[tableD1], &d2 = _table[tableD2];
+	const tableView &sumOrder = _table[tableSumOrder], &orders = _table[tableOrders];
+	const tableView &layout = _table[tableLayout], &orderStart = _table[tableOrderStart];
+
+	for (int i = 0; i < d1.size(); i++) {
+		if (d1[i] < 0 || d1[i] > n || d2[i] < 0 || d2[i] >= n)
+			return false;
+	}
+
+	for (int i = 0; i < n; i++) {
+		int sum = 0, code[2] = { 0, 0 }, weight = 1;	// code как в findHalfMonomials
+		for (int var = 0; var < _variable; var++) {
+			const int power = orders[i * _variable + var];
+			if (power < 0 || power > _order)
+				return false;
+			if (var % size == 0)
+				weight = 1;
+			sum += power;
+			code[var / size] += power * weight;
+			weight *= _order + 1;
+		}
+		if (sum > _order || sumOrder[i] != sum || c1[i] != code[0] || c2[i] != code[1])
+			return false;
+	}
+
+	if (_graded) {
+		vector<bool> seen(n, false);
+		for (int i = 0; i < n; i++) {
+			if (layout[i] < 0 || layout[i] >= n || seen[layout[i]])
+				return false;
+			seen[layout[i]] = true;
+		}
+
+		if (orderStart[0] != 0 || orderStart[_order + 1] != n)
+			return false;
+		for (int d = 0; d <= _order; d++) {
+			if (orderStart[d + 1] < orderStart[d])
+				return false;
+			for (int i = orderStart[d]; i < orderStart[d + 1]; i++) {
+				if (sumOrder[i] != d)
+					return false;
+			}
+		}
+	}
+
+	for (int i = 0; i < n; i++) {
+		const int berz = d1[c1[i]] + d2[c2[i]] - 1;
+		if (berz < 0 || berz >= n || (_graded ? layout[berz] : berz) != i)
+			return false;
+	}
+
+	if (!hasMultSchedule())
+		return true;
+
+	const tableView &start = _table[tableMultStart], &index = _table[tableMultIndex];
+	const tableView &target = _table[tableMultTarget], &overflow = _table[tableMultOverflow];
+	if (start[0] != 0 || start[n] != target.size())
+		return false;
+	for (int i = 0; i < n; i++) {
+		if (start[i + 1] < start[i] || overflow[i] != _order - sumOrder[i] + 1)
+			return false;
+		if (_graded && start[i + 1] - start[i] != orderStart[overflow[i]])
+			return false;
+
+		for (int k = start[i]; k < start[i + 1]; k++) {
+			const int j = _graded ? k - start[i] : index[k];
+			if (j < 0 || j >= n || sumOrder[i] + sumOrder[j] > _order)
+				return false;
+			if (target[k] < 0 || target[k] >= n || sumOrder[target[k]] != sumOrder[i] + sumOrder[j])
+				return false;
+		}
 	}
+	return true;
 }
@@ -3,15 +3,44 @@
 #include <math.h>
 #include <algorithm>
 #include <iostream>
+#include <memory>
+#include <string>
+#include "allocator.h"
+#include "mappedFile.h"
+#include "threadPool.h"
 using std::vector;
 
+// массив таблицы только для чтения: смотрит либо в вектор, построенный в конструкторе,
+// либо в отображённый в память файл таблиц (см. multSerCoef::save)
+class tableView {
+private:
+	const int *_data;
+	int _size;
+
+public:
+	tableView() : _data(nullptr), _size(0) {};
+	tableView(const int *data, int size) : _data(data), _size(size) {};
+	tableView(const vector<int> &v) : _data(v.data()), _size(v.size()) {};
+
+	inline const int* data() const { return _data; }
+	inline int size() const { return _size; }
+	inline bool empty() const { return _size == 0; }
+	inline int operator[](int index) const { return _data[index]; }
+};
+
 // multiplication Series Coefficients
 class multSerCoef {
-	template <typename T> friend class equation;	// чтобы получить доступ к orderTable
-
 private:
+	// таблицы строятся в векторах ниже, а читаются только через _table,
+	// поэтому при загрузке из файла векторы остаются пустыми
+	enum tableName { tableC1, tableC2, tableD1, tableD2, tableSumOrder, tableOrders, tableLayout, tableOrderStart,
+		tableMultStart, tableMultIndex, tableMultTarget, tableMultOverflow, tableCount };
+	tableView _table[tableCount];
+	std::shared_ptr<mappedFile> _file;		// отображённый файл таблиц, если они загружены из него
+	void bindTables();
+
 	vector<int> _sumOrder;	// sumOrder[i] = sum( orderTable[i][0..j] )
-	vector<vector<int> > orderTable;
+	vector<int> orderTable;	// степени переменных i-го члена: [i * _variable; (i + 1) * _variable)
 	vector< vector<int> > D;
 	vector< vector<int> > C;
 	int _order;         // порядок
@@ -20,45 +49,88 @@ private:
 	int _realParameter;     // кол-во параметров системы (alpha, beta...)
 	int _realVariable;	// кол-во переменных (искомых), т.е. x, y, z...
 	int _seriesSize;
+	bool _graded;		// члены ряда упорядочены по степени (см. sortByOrder)
+	vector<int> _layout;		// номер члена в таблице C Берца -> номер в упорядоченном по степени ряде
+	vector<int> _orderStart;	// члены степени d лежат в [_orderStart[d]; _orderStart[d + 1])
+	std::shared_ptr<blockPool> _pool;	// память под коэффициенты рядов этой таблицы
 
-	struct sortTableCoef {
-		int _c1;
-		int _c2;
+	// половина члена ряда: степени первых или последних _variable / 2 переменных
+	struct halfMonomial {
+		int _code;			// sum( order[i] * (_order + 1)^i ), т.е. c1 или c2
 		int _sumOrder;
 		vector<int> _order;
-
-		sortTableCoef() : _c1(0), _c2(0), _sumOrder(0) {};
-		sortTableCoef(int c1, int c2, int sum) : _c1(c1), _c2(c2), _sumOrder(sum) {};
-		inline void setToZero() { _c1 = _c2 = _sumOrder = 0; }	// правильно бы было добавить _order.clear(), 
-																// но в данной реализации это не нужно
 	};
 
+	void setShape(int, int, int, bool);
+	void buildTables();
+	bool load(const std::string&);
+	bool checkTables() const;
+
 	void findC();
-	void findPowArray(vector<int>&);
+	void findHalfMonomials(vector<halfMonomial>&);
 	double findSeriesSize(double, double, double);
-	static bool sortCFirstStep(const sortTableCoef&, const sortTableCoef&);
-	void sortCSecondStep(vector<sortTableCoef>&);
-	void removeByValue(vector<sortTableCoef>&, int);
 
 	void findD();
-	int findDElementC1(int);
-	int findDElementC2(int);
 
+	void sortByOrder();
+
+	// расписание перемножения рядов: для i-го члена подряд лежат все j (по возрастанию),
+	// для которых произведение не выходит за _order, и индекс, куда это произведение попадает
+	vector<int> _multStart;		// пары i-го члена лежат в [_multStart[i]; _multStart[i + 1])
+	vector<int> _multIndex;		// j; при _graded не хранится, т.к. j = 0, 1, 2...
+	vector<int> _multTarget;	// getMultIndex(i, j)
+	vector<int> _multOverflow;	// члены со степенью >= _multOverflow[i] уходят в погрешность J
+	void findMultSchedule();
+
+	// то же расписание, но сгруппированное по индексу произведения: для k-го члена подряд лежат
+	// пары (i, j) в том же порядке, в каком их складывает последовательное перемножение.
+	// Члены разбиты на блоки с примерно равным числом пар, блоки считаются в разных потоках
+	vector<int> _gatherStart;	// пары k-го члена лежат в [_gatherStart[k]; _gatherStart[k + 1])
+	vector<int> _gatherRow;		// i
+	vector<int> _gatherCol;		// j
+	vector<int> _gatherBlock;	// члены блока b: [_gatherBlock[b]; _gatherBlock[b + 1])
+	std::shared_ptr<threadPool> _workers;	// потоки для перемножения рядов
+	void findGatherSchedule();
 
 
 public:
 	multSerCoef() {};
-	multSerCoef(int, int, int);
+	multSerCoef(int, int, int, bool = false);
+	multSerCoef(int, int, int, bool, const std::string&);	// с файлом таблиц, см. save
 	~multSerCoef() {};
+	multSerCoef(const multSerCoef&) = delete;
+	multSerCoef& operator=(const multSerCoef&) = delete;
+
+	bool save(const std::string&) const;
+	inline bool mapped() const { return _file != nullptr; }
 
 	inline int order() const { return _order; }
 	inline int realVariable() const { return _realVariable; }
 	inline int variableEven() const { return _variable; }
 	inline int realParameter() const { return _realParameter; }
 	inline int serieSize() const { return _seriesSize; }
+	inline bool graded() const { return _graded; }
+	inline const std::shared_ptr<blockPool>& pool() const { return _pool; }
+	inline int orderStart(int order) const { return _table[tableOrderStart][order]; }
 
 	int getMultIndex(int, int) const;
 	int getMultOrder(int) const;
+	inline int getVarOrder(int index, int var) const { return _table[tableOrders][index * _variable + var]; }
+	int getVarIndex(int) const;
+
+	inline bool hasMultSchedule() const { return !_table[tableMultStart].empty(); }
+	inline int multStart(int index) const { return _table[tableMultStart][index]; }
+	inline int multOverflow(int index) const { return _table[tableMultOverflow][index]; }
+	inline const int* multIndex() const { return _table[tableMultIndex].data(); }
+	inline const int* multTarget() const { return _table[tableMultTarget].data(); }
+
+	void setThreads(int);
+	inline threadPool* workers() const { return _workers.get(); }
+	inline int gatherBlocks() const { return (int)_gatherBlock.size() - 1; }
+	inline int gatherBlock(int block) const { return _gatherBlock[block]; }
+	inline int gatherStart(int index) const { return _gatherStart[index]; }
+	inline const int* gatherRow() const { return _gatherRow.data(); }
+	inline const int* gatherCol() const { return _gatherCol.data(); }
 
 	void printTableC() const;
 	void printTableD() const;
@@ -0,0 +1,312 @@
+﻿/*
+Числа double-double: значение - сумма hi + lo двух double, |lo| <= ulp(hi) / 2, около 32 значащих цифр.
+Сложение и умножение - AccurateDWPlusDW и DWTimesDW3 из M. Joldes, J.-M. Muller, V. Popescu.
+Tight and rigorous error bounds for basic building blocks of double-word arithmetic, 2017:
+относительная погрешность не больше 3u^2 и 4u^2 (u = 2^-53), операции с double - не больше 2u^2,
+деление и корень - уточнение по Ньютону, не больше ~10u^2. Точное произведение двух double считается
+через fma, если она аппаратная (FP_FAST_FMA, AVX2), иначе разбиением Деккера.
+Em<doubleDouble> = 1e-30 (около 80u^2) покрывает эти погрешности с тем же запасом, что Em<double> у double.
+Суммы для оценок при перемножении рядов копятся в double (см. precision.h), поэтому перемножение
+рядов doubleDouble дороже, чем double, только на сами операции над коэффициентами.
+*/
+
+#pragma once
+#include "interval.h"
+#include "precision.h"
+#include <cmath>
+#include <limits>
+#include <ostream>
+
+#if defined(FP_FAST_FMA) || defined(__FMA__) || defined(__AVX2__)
+#define DOUBLE_DOUBLE_FMA
+#endif
+
+
+class doubleDouble {
+private:
+	double _hi;
+	double _lo;
+
+public:
+	constexpr doubleDouble() : _hi(0), _lo(0) {};
+	constexpr doubleDouble(double x) : _hi(x), _lo(0) {};
+	constexpr doubleDouble(double hi, double lo) : _hi(hi), _lo(lo) {};	// hi + lo уже нормализовано
+
+	inline double hi() const { return _hi; }
+	inline double lo() const { return _lo; }
+	explicit operator double() const { return _hi; }
+
+	// точные преобразования: результат равен a + b (a * b) без округления
+	static inline doubleDouble twoSum(double a, double b) {
+		const double s = a + b, v = s - a;
+		return doubleDouble(s, (a - (s - v)) + (b - v));
+	}
+
+	// то же при |a| >= |b|
+	static inline doubleDouble fastTwoSum(double a, double b) {
+		const double s = a + b;
+		return doubleDouble(s, b - (s - a));
+	}
+
+	// бесконечности и NaN: младшая часть не имеет смысла, результат операции - результат над старшими частями
+	static inline bool finite(double x) { return x - x == 0; }
+
+	static inline doubleDouble twoProd(double a, double b) {
+		const double p = a * b;
+#ifdef DOUBLE_DOUBLE_FMA
+		return doubleDouble(p, std::fma(a, b, -p));
+#else
+		const double split = 134217729.0;		// 2^27 + 1
+		double t = split * a;
+		const double ah = t - (t - a), al = a - ah;
+		t = split * b;
+		const double bh = t - (t - b), bl = b - bh;
+		return doubleDouble(p, ((ah * bh - p) + ah * bl + al * bh) + al * bl);
+#endif
+	}
+
+	friend inline doubleDouble operator-(const doubleDouble &x) { return doubleDouble(-x._hi, -x._lo); }
+
+	friend inline doubleDouble operator+(const doubleDouble &x, const doubleDouble &y) {
+		const doubleDouble s = twoSum(x._hi, y._hi), t = twoSum(x._lo, y._lo);
+		if (!finite(s._hi))
+			return s._hi;
+		const doubleDouble v = fastTwoSum(s._hi, s._lo + t._hi);
+		return fastTwoSum(v._hi, t._lo + v._lo);
+	}
+
+	friend inline doubleDouble operator+(const doubleDouble &x, double y) {
+		const doubleDouble s = twoSum(x._hi, y);
+		if (!finite(s._hi))
+			return s._hi;
+		return fastTwoSum(s._hi, x._lo + s._lo);
+	}
+
+	friend inline doubleDouble operator+(double x, const doubleDouble &y) { return y + x; }
+	friend inline doubleDouble operator-(const doubleDouble &x, const doubleDouble &y) { return x + (-y); }
+	friend inline doubleDouble operator-(const doubleDouble &x, double y) { return x + (-y); }
+	friend inline doubleDouble operator-(double x, const doubleDouble &y) { return (-y) + x; }
+
+	friend inline doubleDouble operator*(const doubleDouble &x, const doubleDouble &y) {
+		const doubleDouble c = twoProd(x._hi, y._hi);
+		if (!finite(c._hi))
+			return c._hi;
+#ifdef DOUBLE_DOUBLE_FMA
+		const double l = std::fma(x._lo, y._hi, std::fma(x._hi, y._lo, x._lo * y._lo));
+#else
+		const double l = x._lo * y._hi + (x._hi * y._lo + x._lo * y._lo);
+#endif
+		return fastTwoSum(c._hi, c._lo + l);
+	}
+
+	friend inline doubleDouble operator*(const doubleDouble &x, double y) {
+		const doubleDouble c = twoProd(x._hi, y);
+		if (!finite(c._hi))
+			return c._hi;
+#ifdef DOUBLE_DOUBLE_FMA
+		return fastTwoSum(c._hi, std::fma(x._lo, y, c._lo));
+#else
+		return fastTwoSum(c._hi, x._lo * y + c._lo);
+#endif
+	}
+
+	friend inline doubleDouble operator*(double x, const doubleDouble &y) { return y * x; }
+
+	// q1 + q2 + q3: каждое следующее частное уточняет остаток предыдущего
+	friend inline doubleDouble operator/(const doubleDouble &x, const doubleDouble &y) {
+		const double q1 = x._hi / y._hi;
+		if (!finite(q1) || !finite(y._hi))
+			return q1;
+		doubleDouble r = x - y * q1;
+		const double q2 = r._hi / y._hi;
+		r = r - y * q2;
+		const double q3 = r._hi / y._hi;
+		return fastTwoSum(q1, q2) + q3;
+	}
+
+	friend inline doubleDouble operator/(const doubleDouble &x, double y) {
+		const double q1 = x._hi / y;
+		if (!finite(q1) || !finite(y))
+			return q1;
+		const doubleDouble p = twoProd(q1, y);
+		const doubleDouble s = twoSum(x._hi, -p._hi);
+		const double q2 = (s._hi + (s._lo + x._lo - p._lo)) / y;
+		return fastTwoSum(q1, q2);
+	}
+
+	inline doubleDouble& operator+=(const doubleDouble &y) { return *this = *this + y; }
+	inline doubleDouble& operator-=(const doubleDouble &y) { return *this = *this - y; }
+	inline doubleDouble& operator*=(const doubleDouble &y) { return *this = *this * y; }
+	inline doubleDouble& operator/=(const doubleDouble &y) { return *this = *this / y; }
+	inline doubleDouble& operator+=(double y) { return *this = *this + y; }
+	inline doubleDouble& operator-=(double y) { return *this = *this - y; }
+	inline doubleDouble& operator*=(double y) { return *this = *this * y; }
+	inline doubleDouble& operator/=(double y) { return *this = *this / y; }
+
+	friend inline bool operator==(const doubleDouble &x, const doubleDouble &y) { return x._hi == y._hi && x._lo == y._lo; }
+	friend inline bool operator!=(const doubleDouble &x, const doubleDouble &y) { return !(x == y); }
+	friend inline bool operator<(const doubleDouble &x, const doubleDouble &y) { return x._hi < y._hi || (x._hi == y._hi && x._lo < y._lo); }
+	friend inline bool operator>(const doubleDouble &x, const doubleDouble &y) { return y < x; }
+	friend inline bool operator<=(const doubleDouble &x, const doubleDouble &y) { return x._hi < y._hi || (x._hi == y._hi && x._lo <= y._lo); }
+	friend inline bool operator>=(const doubleDouble &x, const doubleDouble &y) { return y <= x; }
+
+	// значение с точностью double (для графиков)
+	friend inline std::ostream& operator<<(std::ostream &os, const doubleDouble &x) { return os << x._hi; }
+};
+
+
+namespace std {
+template <>
+class numeric_limits<doubleDouble> {
+public:
+	static constexpr bool is_specialized = true;
+	static constexpr bool is_signed = true;
+	static constexpr bool is_integer = false;
+	static constexpr bool is_exact = false;
+	static constexpr bool has_infinity = true;
+	static constexpr bool has_quiet_NaN = true;
+	static constexpr bool has_signaling_NaN = false;
+	static constexpr bool is_iec559 = false;		// границы интервалов сдвигаются по своей оценке (см. ниже)
+	static constexpr bool is_bounded = true;
+	static constexpr bool is_modulo = false;
+	static constexpr int radix = 2;
+	static constexpr int digits = 106;
+	static constexpr int digits10 = 31;
+	static constexpr int max_digits10 = 33;
+	static constexpr int min_exponent = -968;
+	static constexpr int max_exponent = 1024;
+	static constexpr int min_exponent10 = -291;
+	static constexpr int max_exponent10 = 308;
+
+	// min - наименьшее число, у которого младшая часть ещё не денормализована (2^-969)
+	static constexpr doubleDouble min() noexcept { return doubleDouble(2.004168360008973e-292); }
+	static constexpr doubleDouble max() noexcept { return doubleDouble(1.7976931348623157e308, 9.979201547673598e291); }
+	static constexpr doubleDouble lowest() noexcept { return doubleDouble(-1.7976931348623157e308, -9.979201547673598e291); }
+	static constexpr doubleDouble epsilon() noexcept { return doubleDouble(4.930380657631324e-32); }	// 2^-104
+	static constexpr doubleDouble round_error() noexcept { return doubleDouble(0.5); }
+	static constexpr doubleDouble infinity() noexcept { return doubleDouble(numeric_limits<double>::infinity()); }
+	static constexpr doubleDouble quiet_NaN() noexcept { return doubleDouble(numeric_limits<double>::quiet_NaN()); }
+	static constexpr doubleDouble denorm_min() noexcept { return doubleDouble(numeric_limits<double>::denorm_min()); }
+};
+}
+
+
+inline doubleDouble fabs(const doubleDouble &x) {
+	return (x.hi() < 0) ? -x : x;
+}
+
+// x 2^e, точно, пока младшая часть не уходит в денормализованные числа
+inline doubleDouble ldexp(const doubleDouble &x, int e) {
+	return doubleDouble(std::ldexp(x.hi(), e), std::ldexp(x.lo(), e));
+}
+
+// s + (x - s^2) / 2s, s = sqrt(hi): шаг Ньютона от double удваивает число верных знаков
+inline doubleDouble sqrt(const doubleDouble &x) {
+	if (!(x.hi() > 0) || x.hi() == std::numeric_limits<double>::infinity())
+		return doubleDouble(std::sqrt(x.hi()));		// 0, inf, отрицательные числа и NaN
+	const double s = std::sqrt(x.hi());
+	const doubleDouble r = x - doubleDouble::twoProd(s, s);
+	return doubleDouble::fastTwoSum(s, r.hi() / (2 * s));
+}
+
+// соседнее число в сторону to: младшая часть сдвигается на свой ulp
+inline doubleDouble nextafter(const doubleDouble &x, const doubleDouble &to) {
+	if (x == to || x.hi() != x.hi() || to.hi() != to.hi())
+		return to;
+	const double inf = std::numeric_limits<double>::infinity();
+	return doubleDouble::fastTwoSum(x.hi(), std::nextafter(x.lo(), (to > x) ? inf : -inf));
+}
+
+// x - k c, где c = c0 + c1 + c2 (c0 k и c1 k считаются точно)
+inline doubleDouble reduceArgument(const doubleDouble &x, double k, double c0, double c1, double c2) {
+	return (x - doubleDouble::twoProd(c0, k) - doubleDouble::twoProd(c1, k)) - c2 * k;
+}
+
+/*
+exp(x) = 2^k exp(r), r = x - k ln 2, |r| <= ln 2 / 2; ряд Тейлора exp(r) до r^24 (остаток меньше 1e-34)
+считается по Горнеру: 1 + r (1 + r / 2 (1 + r / 3 (...))).
+*/
+inline doubleDouble exp(const doubleDouble &x) {
+	if (x.hi() != x.hi())
+		return x;
+	if (x.hi() > 709.8)
+		return std::numeric_limits<doubleDouble>::infinity();
+	if (x.hi() < -745.2)
+		return 0;
+
+	const double k = std::floor(x.hi() / 0.6931471805599453 + 0.5);
+	const doubleDouble r = reduceArgument(x, k, 0.6931471805599453, 2.3190468138462996e-17, 5.707708438416212e-34);
+	doubleDouble p = 1;
+	for (int n = 24; n >= 1; n--)
+		p = (r * p) / n + 1.0;
+	return ldexp(p, (int)k);
+}
+
+// sin r и cos r при |r| <= pi / 4: ряды до r^29 и r^28 по Горнеру от r^2
+inline void sinCosReduced(const doubleDouble &r, doubleDouble &s, doubleDouble &c) {
+	const doubleDouble r2 = r * r;
+	s = 1;
+	c = 1;
+	for (int n = 28; n >= 2; n -= 2) {
+		s = 1.0 - (r2 * s) / double((n + 1) * n);
+		c = 1.0 - (r2 * c) / double(n * (n - 1));
+	}
+	s = s * r;
+}
+
+// x = k pi / 2 + r, |r| <= pi / 4; функция выбирается по k mod 4
+inline doubleDouble sinCosQuadrant(const doubleDouble &x, int shift) {
+	const double k = std::floor(x.hi() / 1.5707963267948966 + 0.5);
+	const doubleDouble r = reduceArgument(x, k, 1.5707963267948966, 6.123233995736766e-17, -1.4973849048591698e-33);
+	doubleDouble s, c;
+	sinCosReduced(r, s, c);
+	switch (((long long)k + shift) & 3) {
+	case 0: return s;
+	case 1: return c;
+	case 2: return -s;
+	default: return -c;
+	}
+}
+
+inline doubleDouble sin(const doubleDouble &x) {
+	return sinCosQuadrant(x, 0);
+}
+
+inline doubleDouble cos(const doubleDouble &x) {
+	return sinCosQuadrant(x, 1);
+}
+
+
+template <>
+constexpr doubleDouble Em<doubleDouble> = doubleDouble(1e-30);
+
+template <>
+constexpr doubleDouble Ec<doubleDouble> = doubleDouble(1e-35);
+
+template <>
+struct precision<doubleDouble> {
+	typedef double bound;
+
+	// |hi| (1 + 2^-52) >= |hi| + ulp(hi) >= |hi + lo|
+	static inline bound magnitude(const doubleDouble &x) { return std::fabs(x.hi()) * (1 + std::numeric_limits<double>::epsilon()); }
+
+	static inline doubleDouble exp(const doubleDouble &x) { return ::exp(x); }
+	static inline doubleDouble sin(const doubleDouble &x) { return ::sin(x); }
+	static inline doubleDouble cos(const doubleDouble &x) { return ::cos(x); }
+	static inline doubleDouble sqrt(const doubleDouble &x) { return ::sqrt(x); }
+	static inline doubleDouble nextafter(const doubleDouble &x, const doubleDouble &to) { return ::nextafter(x, to); }
+};
+
+/*
+Операции doubleDouble не округляются правильно, поэтому граница интервала сдвигается
+на худшую погрешность операции (деление, около 10u^2) с запасом: |c| 2^-102 + наименьшее денормализованное число.
+*/
+template <>
+struct outwardRounding<doubleDouble, false> {
+	static inline doubleDouble step(const doubleDouble &c) {
+		const doubleDouble s = fabs(c) * 1.9721522630525295e-31 + std::numeric_limits<double>::denorm_min();
+		return (s < std::numeric_limits<doubleDouble>::max()) ? s : std::numeric_limits<doubleDouble>::max();
+	}
+	static inline doubleDouble down(const doubleDouble &c) { return c - step(c); }
+	static inline doubleDouble up(const doubleDouble &c) { return c + step(c); }
+};
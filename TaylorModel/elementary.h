@@ -0,0 +1,252 @@
+﻿/*
+Элементарные функции от рядов: exp, sin, cos, sqrt и 1/x.
+Ряд x раскладывается на член нулевой степени c и остальную часть h = x - c, |h| <= B на области
+определения (переменные на [-1; 1], как и в оценке отброшенных членов при перемножении). Тогда
+
+	f(x) = a[0] + a[1] h + ... + a[n] h^n + R,	a[k] = f^(k)(c) / k!,
+	|R| <= max |f^(n+1)| / (n+1)! * B^(n+1) на [c - B; c + B],
+
+и R вместе с погрешностью округления a[k] уходит в остаточный интервал результата.
+Многочлен от h считается по схеме Горнера от h^s с заранее посчитанными h^2..h^s (Патерсон - Стокмейер):
+около 2 sqrt(n) перемножений рядов вместо n. n - наименьшая степень, при которой R пренебрежимо мал,
+но не больше порядка ряда, поэтому при узкой области перемножений ещё меньше.
+sincos считает обе функции по общим степеням h. 1/x считается не так, а итерациями Ньютона
+(см. powerSeries::reciprocal): оценка остатка там не зависит от производных и гораздо точнее.
+*/
+
+#pragma once
+#include "series.h"
+#include <cmath>
+#include <limits>
+
+
+// B: |x - x[0]| на области определения вместе с остаточным интервалом
+template <typename T>
+T seriesRadius(const powerSeries<T> &x) {
+	seriesView<T> s = x.coefficients();
+	T B = 0;
+	for (int k = 1; k < s.size(); k++)
+		B += mabs(s[k]);
+	B += std::max(mabs(x.error().begin()), mabs(x.error().end()));
+	return B * (1 + Em<T>*E);
+}
+
+/*
+Степень многочлена и оценка остатка: a[k] - коэффициенты Тейлора, M[k] - оценка |f^(k)| / k! на [c - B; c + B]
+(оба массива длины order + 2). Берётся первая степень, при которой остаток пренебрежимо мал, а если такой нет -
+степень с наименьшим остатком (у sqrt при B больше расстояния до нуля остаток с ростом n растёт).
+Возвращает n и прибавляет к bound остаток и погрешность округления a[0..n].
+*/
+template <typename T>
+int taylorDegree(const vector<T> &a, const vector<T> &M, T B, T &bound) {
+	const int order = a.size() - 2;
+	T scale = 0, rounding = 0, Bk = 1;
+	int best = 0;
+	T bestBound = std::numeric_limits<T>::infinity();
+	for (int n = 0; n <= order; n++) {
+		scale += mabs(a[n]) * Bk;
+		rounding += mabs(a[n]) * Bk * (n + 2);
+		Bk *= B;
+
+		const T remainder = M[n + 1] * Bk;
+		const T total = (remainder + rounding * Em<T>*E) * (1 + Em<T>*E);
+		if (total < bestBound) {
+			best = n;
+			bestBound = total;
+		}
+		if (remainder <= scale * Em<T>)
+			break;
+	}
+	bound += bestBound;
+	return best;
+}
+
+// число степеней h, которые стоит посчитать заранее: s - 1 + ceil((n + 1) / s) - 1 перемножений - наименьшее
+inline int powerBlock(int n) {
+	int best = 1;
+	for (int s = 2; s <= n + 1; s++) {
+		if (s - 1 + (n + s) / s - 1 < best - 1 + (n + best) / best - 1)
+			best = s;
+	}
+	return best;
+}
+
+// h = x - x[0] и его степени: powers[i] = h^i, i = 1..s
+template <typename T>
+void seriesPowers(const powerSeries<T> &x, int s, vector<powerSeries<T> > &powers) {
+	powers.assign(s + 1, powerSeries<T>(x.coefficients().size(), x.table()));
+	powers[1] = x;
+	powers[1].serie(0, 0);
+	for (int i = 2; i <= s; i++)
+		powers[i].mul(powers[i - 1], powers[1]);
+}
+
+/*
+a[0] + a[1] h + ... + a[n] h^n + [-bound; bound] по степеням из seriesPowers: многочлен делится на блоки
+по s членов, внутри блока степени h берутся готовыми (сложение с множителем), а сами блоки складываются
+по схеме Горнера от h^s. Перемножений s - 1 + ceil((n + 1) / s) - 1 вместо n.
+*/
+template <typename T>
+powerSeries<T> taylorHorner(const vector<powerSeries<T> > &powers, const vector<T> &a, int n, T bound) {
+	const int s = powers.size() - 1;
+	const int size = powers[1].coefficients().size();
+	const multSerCoef *table = powers[1].table();
+
+	// j-й блок: a[js] + a[js + 1] h + ... + a[js + s - 1] h^(s - 1), прибавляется к r
+	auto addBlock = [&](powerSeries<T> &r, int j) {
+		for (int i = 1; i < s && j * s + i <= n; i++)
+			r.axpy(powers[i], a[j * s + i]);
+		r.shift(a[j * s]);
+	};
+
+	const int blocks = n / s;
+	powerSeries<T> p(size, table), q(size, table);
+	powerSeries<T> *r = &p, *next = &q;
+	addBlock(*r, blocks);
+	for (int j = blocks - 1; j >= 0; j--) {
+		next->mul(*r, powers[s]);
+		addBlock(*next, j);
+		std::swap(r, next);
+	}
+
+	interval<T> error = r->error() + interval<T>(-bound, bound);
+	r->error(error.begin(), error.end());
+	return std::move(*r);
+}
+
+template <typename T>
+powerSeries<T> taylorCompose(const powerSeries<T> &x, const vector<T> &a, int n, T bound) {
+	vector<powerSeries<T> > powers;
+	seriesPowers(x, powerBlock(n), powers);
+	return taylorHorner(powers, a, n, bound);
+}
+
+// ряд с неограниченным остаточным интервалом: x уже ничего не говорит о значении функции
+template <typename T>
+powerSeries<T> unboundedSeries(const powerSeries<T> &x) {
+	powerSeries<T> r(x.coefficients().size(), x.table());
+	const T inf = std::numeric_limits<T>::infinity();
+	r.error(-inf, inf);
+	return r;
+}
+
+
+template <typename T>
+powerSeries<T> exp(const powerSeries<T> &x) {
+	const T c = x[0], B = seriesRadius(x);
+	if (!(B < std::numeric_limits<T>::infinity()))
+		return unboundedSeries(x);
+
+	const int order = x.table()->order();
+	vector<T> a(order + 2), M(order + 2);
+	a[0] = precision<T>::exp(c);
+	M[0] = precision<T>::exp(c + B) * (1 + Em<T>*E);	// exp возрастает, наибольшая производная - на правом конце
+	for (int k = 1; k < order + 2; k++) {
+		a[k] = a[k - 1] / k;
+		M[k] = M[k - 1] / k;
+	}
+
+	T bound = 0;
+	const int n = taylorDegree(a, M, B, bound);
+	return taylorCompose(x, a, n, bound);
+}
+
+// коэффициенты Тейлора sin (shift = 0) или cos (shift = 1) в точке c; производные не больше 1
+template <typename T>
+void trigonometricTaylor(T c, int shift, vector<T> &a, vector<T> &M) {
+	const T value[4] = { precision<T>::sin(c), precision<T>::cos(c), -precision<T>::sin(c), -precision<T>::cos(c) };
+	const int n = a.size();
+	T factorial = 1;
+	for (int k = 0; k < n; k++) {
+		if (k > 0)
+			factorial /= k;
+		a[k] = value[(k + shift) % 4] * factorial;
+		M[k] = factorial * (1 + Em<T>*E);
+	}
+}
+
+template <typename T>
+powerSeries<T> sin(const powerSeries<T> &x) {
+	const T B = seriesRadius(x);
+	if (!(B < std::numeric_limits<T>::infinity()))
+		return unboundedSeries(x);
+
+	vector<T> a(x.table()->order() + 2), M(a.size());
+	trigonometricTaylor(x[0], 0, a, M);
+	T bound = 0;
+	const int n = taylorDegree(a, M, B, bound);
+	return taylorCompose(x, a, n, bound);
+}
+
+template <typename T>
+powerSeries<T> cos(const powerSeries<T> &x) {
+	const T B = seriesRadius(x);
+	if (!(B < std::numeric_limits<T>::infinity()))
+		return unboundedSeries(x);
+
+	vector<T> a(x.table()->order() + 2), M(a.size());
+	trigonometricTaylor(x[0], 1, a, M);
+	T bound = 0;
+	const int n = taylorDegree(a, M, B, bound);
+	return taylorCompose(x, a, n, bound);
+}
+
+// s = sin(x), c = cos(x): степени h считаются один раз на обе функции
+template <typename T>
+void sincos(const powerSeries<T> &x, powerSeries<T> &s, powerSeries<T> &c) {
+	const T B = seriesRadius(x);
+	if (!(B < std::numeric_limits<T>::infinity())) {
+		s = unboundedSeries(x);
+		c = unboundedSeries(x);
+		return;
+	}
+
+	vector<T> as(x.table()->order() + 2), ac(as.size()), M(as.size());
+	trigonometricTaylor(x[0], 0, as, M);
+	trigonometricTaylor(x[0], 1, ac, M);
+	T boundS = 0, boundC = 0;
+	const int n = std::max(taylorDegree(as, M, B, boundS), taylorDegree(ac, M, B, boundC));
+
+	vector<powerSeries<T> > powers;
+	seriesPowers(x, powerBlock(n), powers);
+	s = taylorHorner(powers, as, n, boundS);
+	c = taylorHorner(powers, ac, n, boundC);
+}
+
+// x^(1/2), x > 0 на всей области; иначе outOfDomain
+template <typename T>
+powerSeries<T> sqrt(const powerSeries<T> &x) {
+	const T c = x[0], B = seriesRadius(x);
+	if (!(B < std::numeric_limits<T>::infinity()))
+		return unboundedSeries(x);
+	const T low = c - B - mabs(c)*Em<T>*E;	// нижняя граница x
+	if (!(low > 0))
+		throw typename powerSeries<T>::outOfDomain();
+
+	// f^(k)(t) / k! = C(1/2, k) t^(1/2 - k), по модулю убывает с ростом t
+	const int order = x.table()->order();
+	vector<T> a(order + 2), M(order + 2);
+	T binom = 1;
+	a[0] = precision<T>::sqrt(c);
+	M[0] = precision<T>::sqrt(c + B) * (1 + Em<T>*E);
+	const T rootLow = precision<T>::sqrt(low);
+	T lowPower = 1;
+	for (int k = 1; k < order + 2; k++) {
+		binom *= (T(0.5) - (k - 1)) / k;
+		a[k] = a[k - 1] * (T(0.5) - (k - 1)) / (k * c);
+		lowPower *= low;
+		M[k] = mabs(binom) * rootLow / lowPower * (1 + (k + 2)*Em<T>*E);
+	}
+
+	T bound = 0;
+	const int n = taylorDegree(a, M, B, bound);
+	return taylorCompose(x, a, n, bound);
+}
+
+// 1/x, см. powerSeries::reciprocal
+template <typename T>
+powerSeries<T> reciprocal(const powerSeries<T> &x) {
+	powerSeries<T> r(x.coefficients().size(), x.table());
+	r.reciprocal(x);
+	return r;
+}
@@ -0,0 +1,100 @@
+﻿/*
+Значения ряда сразу во многих точках (например, для вывода графиков).
+Степени каждой переменной во всех точках считаются один раз (таблица степеней), после чего
+член ряда в каждой точке - произведение нескольких строк этой таблицы. pow не вызывается,
+а все циклы идут по точкам подряд по памяти, поэтому компилятор их векторизует.
+*/
+
+#pragma once
+#include "series.h"
+
+
+template <typename T>
+class seriesEvaluator {
+private:
+	const multSerCoef *_coef;
+	int _vars;				// переменные и параметры системы
+	int _count;				// точек
+	vector<int> _termStart;	// ненулевые степени k-го члена лежат в [_termStart[k]; _termStart[k + 1])
+	vector<int> _termRow;	// номер строки таблицы степеней
+	vector<T> _powers;		// _powers[(v * (order + 1) + e) * _count + p] = x_v(p)^e
+	vector<T> _term;
+
+public:
+	class notTheSameLength {};
+	class notTheSameTable {};
+
+	explicit seriesEvaluator(const multSerCoef*);
+
+	inline int size() const { return _count; }
+	void setPoints(const vector<vector<T> >&);		// points[v][p] - v-я переменная p-й точки
+	void evaluate(const powerSeries<T>&, T*);		// res[p] для всех точек
+};
+
+template <typename T>
+seriesEvaluator<T>::seriesEvaluator(const multSerCoef *coef)
+	: _coef(coef), _vars(coef->realVariable() + coef->realParameter()), _count(0) {
+	_termStart.reserve(coef->serieSize() + 1);
+	for (int k = 0; k < coef->serieSize(); k++) {
+		_termStart.push_back(_termRow.size());
+		for (int v = 0; v < _vars; v++) {
+			const int e = coef->getVarOrder(k, v);
+			if (e > 0)
+				_termRow.push_back(v * (coef->order() + 1) + e);
+		}
+	}
+	_termStart.push_back(_termRow.size());
+}
+
+template <typename T>
+void seriesEvaluator<T>::setPoints(const vector<vector<T> > &points) {
+	if ((int)points.size() != _vars)
+		throw notTheSameLength();
+
+	_count = points.empty() ? 0 : points[0].size();
+	const int order = _coef->order();
+	_powers.resize((size_t)_vars * (order + 1) * _count);
+	_term.resize(_count);
+
+	for (int v = 0; v < _vars; v++) {
+		if ((int)points[v].size() != _count)
+			throw notTheSameLength();
+
+		T *row = _powers.data() + (size_t)v * (order + 1) * _count;
+		for (int p = 0; p < _count; p++)
+			row[p] = 1;
+		for (int e = 1; e <= order; e++) {
+			const T *prev = row + (size_t)(e - 1) * _count;
+			T *cur = row + (size_t)e * _count;
+			for (int p = 0; p < _count; p++)
+				cur[p] = prev[p] * points[v][p];
+		}
+	}
+}
+
+// члены складываются в порядке ряда, как и при суммировании по одной точке
+template <typename T>
+void seriesEvaluator<T>::evaluate(const powerSeries<T> &s, T *res) {
+	if (s.table() != _coef)
+		throw notTheSameTable();
+
+	seriesView<T> c = s.coefficients();
+	T *term = _term.data();
+	for (int p = 0; p < _count; p++)
+		res[p] = 0;
+
+	for (int k = 0; k < c.size(); k++) {
+		if (c[k] == 0)
+			continue;
+
+		for (int p = 0; p < _count; p++)
+			term[p] = c[k];
+		for (int q = _termStart[k]; q < _termStart[k + 1]; q++) {
+			const T *row = _powers.data() + (size_t)_termRow[q] * _count;
+			for (int p = 0; p < _count; p++)
+				term[p] *= row[p];
+		}
+		for (int p = 0; p < _count; p++)
+			res[p] += term[p];
+	}
+}
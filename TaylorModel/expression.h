@@ -0,0 +1,332 @@
+﻿/*
+Правая часть системы в виде графа выражений над рядами (см. equation::setRHS).
+Граф строится при работе программы через expression и перегруженные операторы:
+
+	expressionGraph<double> g(2);			// u[0], u[1]
+	expression<double> x = g.variable(0), y = g.variable(1);
+	g.setOutput(0, y);
+	g.setOutput(1, x * x);				// то же, что pFun1 и pFun2 в odu.h
+
+Кроме арифметики доступны exp, sin, cos, sqrt и c / x (см. elementary.h).
+Одинаковые подвыражения (та же операция над теми же узлами) заводятся один раз,
+поэтому x * y в двух уравнениях перемножается один раз за вычисление правой части.
+compile() выбрасывает узлы, не нужные ни одному уравнению, и раздаёт узлам временные ряды так,
+что ряд узла переиспользуется, как только его значение больше не нужно.
+*/
+
+#pragma once
+#include "elementary.h"
+#include <map>
+#include <tuple>
+
+
+template <typename T>
+class expressionGraph;
+
+// узел графа; операции над выражениями добавляют узлы в тот же граф
+template <typename T>
+class expression {
+private:
+	expressionGraph<T> *_graph;
+	int _node;
+
+public:
+	expression(expressionGraph<T> *graph, int node) : _graph(graph), _node(node) {};
+
+	inline expressionGraph<T>* graph() const { return _graph; }
+	inline int node() const { return _node; }
+
+	friend expression operator+(const expression &a, const expression &b) { return a._graph->binary(expressionGraph<T>::opAdd, a, b); }
+	friend expression operator-(const expression &a, const expression &b) { return a._graph->binary(expressionGraph<T>::opSub, a, b); }
+	friend expression operator*(const expression &a, const expression &b) { return a._graph->binary(expressionGraph<T>::opMul, a, b); }
+	friend expression operator/(const expression &a, const expression &b) { return a._graph->binary(expressionGraph<T>::opQuotient, a, b); }
+
+	friend expression operator*(const expression &a, const T &c) { return a._graph->scalar(expressionGraph<T>::opScale, a, c); }
+	friend expression operator*(const T &c, const expression &a) { return a._graph->scalar(expressionGraph<T>::opScale, a, c); }
+	friend expression operator/(const expression &a, const T &c) { return a._graph->scalar(expressionGraph<T>::opDiv, a, c); }
+	friend expression operator+(const expression &a, const T &c) { return a._graph->scalar(expressionGraph<T>::opShift, a, c); }
+	friend expression operator+(const T &c, const expression &a) { return a._graph->scalar(expressionGraph<T>::opShift, a, c); }
+	friend expression operator-(const expression &a, const T &c) { return a._graph->scalar(expressionGraph<T>::opShift, a, -c); }
+	friend expression operator-(const T &c, const expression &a) { return (-a) + c; }
+	friend expression operator-(const expression &a) { return a._graph->scalar(expressionGraph<T>::opScale, a, -1); }
+	friend expression operator/(const T &c, const expression &a) { return a._graph->scalar(expressionGraph<T>::opReciprocal, a, 0) * c; }
+
+	friend expression exp(const expression &a) { return a._graph->scalar(expressionGraph<T>::opExp, a, 0); }
+	friend expression sin(const expression &a) { return a._graph->scalar(expressionGraph<T>::opSin, a, 0); }
+	friend expression cos(const expression &a) { return a._graph->scalar(expressionGraph<T>::opCos, a, 0); }
+	friend expression sqrt(const expression &a) { return a._graph->scalar(expressionGraph<T>::opSqrt, a, 0); }
+};
+
+// a^n, n >= 1, возведением в квадрат; степени, уже построенные в графе, не пересчитываются
+template <typename T>
+expression<T> pow(const expression<T> &a, int n) {
+	if (n < 1)
+		throw typename expressionGraph<T>::badPower();
+	if (n == 1)
+		return a;
+
+	expression<T> half = pow(a, n / 2);
+	expression<T> square = half * half;
+	return (n % 2) ? square * a : square;
+}
+
+
+template <typename T>
+class expressionGraph {
+public:
+	enum operation { opVariable, opAdd, opSub, opMul, opScale, opDiv, opShift, opExp, opSin, opCos, opSqrt, opReciprocal, opQuotient };
+
+	class notTheSameGraph {};
+	class badVariable {};
+	class outputNotSet {};
+	class badPower {};
+	class notCompiled {};
+
+	struct node {
+		operation op;
+		int a, b;		// операнды (номера узлов), для opVariable a - номер переменной
+		T c;			// число для opScale, opDiv, opShift
+	};
+
+private:
+	int _variables;
+	vector<node> _nodes;
+	vector<int> _outputs;						// узел i-го уравнения, -1 - не задан
+	std::map<std::tuple<int, int, int, T>, int> _known;	// (операция, a, b, c) -> узел
+
+	// результат compile
+	vector<int> _order;		// вычисляемые узлы в порядке вычисления
+	vector<int> _slot;		// временный ряд узла; -1 - пишется прямо в результат (_direct)
+	vector<int> _direct;	// номер уравнения, в результат которого сразу пишется узел, или -1
+	int _slots;
+	bool _compiled;
+
+	int add(operation, int, int, T);
+
+public:
+	explicit expressionGraph(int variables) : _variables(variables), _slots(0), _compiled(false) {};
+
+	inline int variables() const { return _variables; }
+	inline int outputs() const { return _outputs.size(); }
+	inline int nodes() const { return _nodes.size(); }
+	inline int slots() const { return _slots; }		// сколько временных рядов нужно evaluate
+	int multiplications() const;					// перемножений рядов за одно вычисление (без элементарных функций)
+
+	expression<T> variable(int);
+	expression<T> binary(operation, const expression<T>&, const expression<T>&);	// для операторов expression
+	expression<T> scalar(operation, const expression<T>&, T);
+	void setOutput(int, const expression<T>&);
+	void compile();
+
+	// обход узлов вне evaluate (см. equation::picardTaylor), после compile
+	inline const node& at(int k) const { return _nodes[k]; }
+	inline const vector<int>& evaluationOrder() const { return _order; }
+	inline int output(int i) const { return _outputs[i]; }
+
+	template <typename S>	// powerSeries<T> или batchSeries<T> (ряды пакета, см. batchSeries.h)
+	void evaluate(const vector<S>&, const vector<S>&, vector<S>&, vector<S>&) const;
+};
+
+template <typename T>
+int expressionGraph<T>::add(operation op, int a, int b, T c) {
+	if ((op == opAdd || op == opMul) && b < a)
+		std::swap(a, b);	// a + b и b + a - один узел
+
+	auto key = std::make_tuple((int)op, a, b, c);
+	auto it = _known.find(key);
+	if (it != _known.end())
+		return it->second;
+
+	_nodes.push_back({ op, a, b, c });
+	_known[key] = _nodes.size() - 1;
+	_compiled = false;
+	return _nodes.size() - 1;
+}
+
+template <typename T>
+expression<T> expressionGraph<T>::binary(operation op, const expression<T> &a, const expression<T> &b) {
+	if (a.graph() != this || b.graph() != this)
+		throw notTheSameGraph();
+	return expression<T>(this, add(op, a.node(), b.node(), 0));
+}
+
+template <typename T>
+expression<T> expressionGraph<T>::scalar(operation op, const expression<T> &a, T c) {
+	if (a.graph() != this)
+		throw notTheSameGraph();
+	return expression<T>(this, add(op, a.node(), -1, c));
+}
+
+// u[var]: переменные системы, затем параметры (как в initialFlow)
+template <typename T>
+expression<T> expressionGraph<T>::variable(int var) {
+	if (var < 0 || var >= _variables)
+		throw badVariable();
+	return expression<T>(this, add(opVariable, var, -1, 0));
+}
+
+template <typename T>
+void expressionGraph<T>::setOutput(int equation, const expression<T> &e) {
+	if (e.graph() != this)
+		throw notTheSameGraph();
+	if (equation >= _outputs.size())
+		_outputs.resize(equation + 1, -1);
+	_outputs[equation] = e.node();
+	_compiled = false;
+}
+
+template <typename T>
+int expressionGraph<T>::multiplications() const {
+	int count = 0;
+	for (int n : _order)
+		count += (_nodes[n].op == opMul);
+	return count;
+}
+
+/*
+Узлы добавляются только после своих операндов, поэтому порядок добавления уже топологический.
+Остаются узлы, от которых зависит хотя бы одно уравнение. Временный ряд узла освобождается
+после последнего использования и достаётся следующему узлу; узел, который нужен только
+одному уравнению и больше никому, пишется сразу в результат этого уравнения.
+*/
+template <typename T>
+void expressionGraph<T>::compile() {
+	const int n = _nodes.size();
+	vector<char> live(n, 0);
+	vector<int> uses(n, 0), outputUses(n, 0);
+
+	for (int i = 0; i < _outputs.size(); i++) {
+		if (_outputs[i] < 0)
+			throw outputNotSet();
+		live[_outputs[i]] = 1;
+		outputUses[_outputs[i]]++;
+	}
+	for (int k = n - 1; k >= 0; k--) {
+		if (!live[k] || _nodes[k].op == opVariable)
+			continue;
+		live[_nodes[k].a] = 1;
+		uses[_nodes[k].a]++;
+		if (_nodes[k].b >= 0) {
+			live[_nodes[k].b] = 1;
+			uses[_nodes[k].b]++;
+		}
+	}
+
+	_order.clear();
+	_slot.assign(n, -1);
+	_direct.assign(n, -1);
+	for (int k = 0; k < n; k++) {
+		if (live[k] && _nodes[k].op != opVariable)
+			_order.push_back(k);
+	}
+	for (int i = 0; i < _outputs.size(); i++) {
+		const int k = _outputs[i];
+		if (_nodes[k].op != opVariable && uses[k] == 0 && outputUses[k] == 1)
+			_direct[k] = i;
+	}
+
+	// последнее использование узла (позиция в _order); узлы-результаты нужны до конца
+	vector<int> last(n, -1);
+	for (int p = 0; p < _order.size(); p++) {
+		last[_nodes[_order[p]].a] = p;
+		if (_nodes[_order[p]].b >= 0)
+			last[_nodes[_order[p]].b] = p;
+	}
+	for (int k : _outputs)
+		last[k] = _order.size();
+
+	vector<int> free;
+	_slots = 0;
+	for (int p = 0; p < _order.size(); p++) {
+		const int k = _order[p];
+		if (_direct[k] == -1) {
+			if (free.empty())
+				_slot[k] = _slots++;
+			else {
+				_slot[k] = free.back();
+				free.pop_back();
+			}
+		}
+
+		const int a = _nodes[k].a, b = _nodes[k].b;
+		if (_slot[a] != -1 && last[a] == p)
+			free.push_back(_slot[a]);
+		if (b >= 0 && b != a && _slot[b] != -1 && last[b] == p)
+			free.push_back(_slot[b]);
+	}
+	_compiled = true;
+}
+
+/*
+res[i] = значение i-го уравнения. Переменная var берётся из state[var], если var < outputs(),
+иначе (параметр системы) из param[var]. slots - временные ряды, их должно быть не меньше slots();
+после первого вычисления они уже нужной длины, и память не выделяется.
+*/
+template <typename T>
+template <typename S>
+void expressionGraph<T>::evaluate(const vector<S> &state, const vector<S> &param, vector<S> &res, vector<S> &slots) const {
+	if (!_compiled)
+		throw notCompiled();
+
+	const int states = _outputs.size();
+	auto value = [&](int k) -> const S& {
+		const node &x = _nodes[k];
+		if (x.op == opVariable)
+			return (x.a < states) ? state[x.a] : param[x.a];
+		return (_direct[k] != -1) ? res[_direct[k]] : slots[_slot[k]];
+	};
+
+	for (int k : _order) {
+		const node &x = _nodes[k];
+		S &r = (_direct[k] != -1) ? res[_direct[k]] : slots[_slot[k]];
+
+		switch (x.op) {
+		case opAdd:
+			r.add(value(x.a), value(x.b));
+			break;
+		case opSub:
+			r = value(x.a);
+			r -= value(x.b);
+			break;
+		case opMul:
+			r.mul(value(x.a), value(x.b));
+			break;
+		case opScale:
+			r.scale(value(x.a), x.c);
+			break;
+		case opDiv:
+			r = value(x.a);
+			r /= x.c;
+			break;
+		case opShift:
+			r = value(x.a);
+			r.shift(x.c);
+			break;
+		case opExp:
+			r = exp(value(x.a));
+			break;
+		case opSin:
+			r = sin(value(x.a));
+			break;
+		case opCos:
+			r = cos(value(x.a));
+			break;
+		case opSqrt:
+			r = sqrt(value(x.a));
+			break;
+		case opReciprocal:
+			r.reciprocal(value(x.a));
+			break;
+		case opQuotient:
+			r = value(x.a) / value(x.b);
+			break;
+		default:
+			break;
+		}
+	}
+
+	for (int i = 0; i < states; i++) {
+		if (_direct[_outputs[i]] != i)
+			res[i] = value(_outputs[i]);
+	}
+}
@@ -0,0 +1,262 @@
+﻿/*
+Ряды фиксированной формы: powerSeries<T, NVars, Order>.
+Число переменных NVars и порядок Order известны при компиляции, поэтому длина ряда
+и расписание перемножения считаются constexpr, а коэффициенты лежат в std::array:
+куча не используется, таблица multSerCoef не нужна, а длины всех циклов известны компилятору.
+
+Члены ряда упорядочены по степени, внутри одной степени - по убыванию степени первой переменной,
+затем второй и т.д. Как и в multSerCoef с graded = true, для члена степени d допустимые
+множители - это префикс ряда со степенями не выше Order - d.
+Погрешность считается так же, как в powerSeries<T>.
+
+Под MSVC для больших форм может понадобиться ключ /constexpr:steps (он задан в проекте).
+*/
+
+#pragma once
+#include "series.h"
+#include <array>
+
+
+// C(n, k)
+constexpr int binomial(int n, int k) {
+	long long r = 1;
+	for (int i = 1; i <= k; i++)
+		r = r * (n - k + i) / i;
+	return (int)r;
+}
+
+template <int NVars, int Order>
+struct fixedShape {
+	static constexpr int size = binomial(NVars + Order, NVars);			// членов в ряде
+	static constexpr int pairs = binomial(2 * NVars + Order, 2 * NVars);	// пар (i, j) со степенью не выше Order
+
+	int degree[size];
+	int exponent[size][NVars];
+	int orderStart[Order + 2];	// члены степени d лежат в [orderStart[d]; orderStart[d + 1])
+	int multStart[size + 1];	// пары i-го члена лежат в [multStart[i]; multStart[i + 1]), j = 0, 1, 2...
+	int multTarget[pairs];		// номер члена, куда попадает произведение
+
+	constexpr fixedShape() : degree{}, exponent{}, orderStart{}, multStart{}, multTarget{} {
+		int e[NVars] = {};
+		int k = 0;
+		for (int d = 0; d <= Order; d++) {
+			orderStart[d] = k;
+
+			// первый член степени d - (d, 0, ..., 0), последний - (0, ..., 0, d)
+			e[0] = d;
+			for (int v = 1; v < NVars; v++)
+				e[v] = 0;
+			while (true) {
+				degree[k] = d;
+				for (int v = 0; v < NVars; v++)
+					exponent[k][v] = e[v];
+				k++;
+
+				// следующий член: уменьшаем последнюю ненулевую степень перед последней переменной,
+				// а весь остаток степени переносим на следующую за ней переменную
+				int p = NVars - 2;
+				while (p >= 0 && e[p] == 0)
+					p--;
+				if (p < 0)
+					break;
+				int rest = 1;
+				for (int v = p + 1; v < NVars; v++) {
+					rest += e[v];
+					e[v] = 0;
+				}
+				e[p]--;
+				e[p + 1] = rest;
+			}
+		}
+		orderStart[Order + 1] = k;
+
+		int q = 0;
+		for (int i = 0; i < size; i++) {
+			multStart[i] = q;
+			for (int j = 0; j < orderStart[Order - degree[i] + 1]; j++) {
+				for (int v = 0; v < NVars; v++)
+					e[v] = exponent[i][v] + exponent[j][v];
+				multTarget[q++] = index(e, degree[i] + degree[j]);
+			}
+		}
+		multStart[size] = q;
+	}
+
+	// номер члена со степенями e и суммарной степенью d
+	constexpr int index(const int *e, int d) const {
+		int r = (d > 0) ? binomial(NVars + d - 1, NVars) : 0;	// членов степени меньше d
+		for (int v = 0; v + 1 < NVars; v++) {
+			// сколько членов с тем же началом имеют на месте v степень больше e[v]
+			if (d > e[v])
+				r += binomial(d - e[v] - 1 + NVars - v - 1, NVars - v - 1);
+			d -= e[v];
+		}
+		return r;
+	}
+};
+
+
+template <typename T, int NVars, int Order>
+class powerSeries {
+	static_assert(NVars > 0 && Order >= 0, "powerSeries<T, NVars, Order> needs NVars > 0 and Order >= 0");
+	typedef fixedShape<NVars, Order> shape;
+
+private:
+	static constexpr shape _shape = shape();
+
+	std::array<T, shape::size> _series;
+	interval<T> _error;
+
+public:
+	class outOfRange {};
+	class divideByZero {};
+
+	powerSeries() : _error(interval<T>(0)) { _series.fill(0); }
+
+	static constexpr int size() { return shape::size; }
+	static constexpr int variableIndex(int var) { return 1 + var; }	// член первой степени переменной var
+	static constexpr int termOrder(int index) { return _shape.degree[index]; }
+	static constexpr int varOrder(int index, int var) { return _shape.exponent[index][var]; }
+
+	inline seriesView<T> coefficients() const { return seriesView<T>(_series.data(), shape::size); }
+	inline T serie(int index) const { return _series[index]; }
+	inline void serie(int index, T t) { _series[index] = t; }
+
+	inline interval<T> error() const { return _error; }
+	inline void error(T begin, T end) { _error = interval<T>(begin, end); }
+
+	inline T operator[](int index) const { return _series[index]; }
+	inline T& operator[](int index) {
+		if (index < 0 || index >= shape::size)
+			throw outOfRange();
+		return _series[index];
+	}
+
+
+	powerSeries& operator+=(const powerSeries &ps) { return add(*this, ps); }
+	powerSeries operator+(const powerSeries &ps) const { powerSeries r; return r.add(*this, ps); }
+
+	powerSeries& operator-=(const powerSeries&);
+	powerSeries operator-(const powerSeries &ps) const { powerSeries r(*this); return r -= ps; }
+
+	powerSeries& operator*=(const T&);
+	powerSeries operator*(const T &a) const { powerSeries r(*this); return r *= a; }
+	powerSeries operator*(const powerSeries &ps) const { powerSeries r; return r.mul(*this, ps); }
+
+	powerSeries& operator/=(const T&);
+	powerSeries operator/(const T &a) const { powerSeries r(*this); return r /= a; }
+
+	powerSeries& add(const powerSeries&, const powerSeries&);	// *this = a + b
+	powerSeries& axpy(const powerSeries &x, const T &a) { return axpy(*this, x, a); }	// *this = *this + x * a
+	powerSeries& axpy(const powerSeries&, const powerSeries&, const T&);	// *this = u + x * a
+	powerSeries& mul(const powerSeries&, const powerSeries&);	// *this = a * b
+};
+
+template <typename T, int NVars, int Order>
+constexpr fixedShape<NVars, Order> powerSeries<T, NVars, Order>::_shape;
+
+template <typename T, int NVars, int Order>
+powerSeries<T, NVars, Order>& powerSeries<T, NVars, Order>::add(const powerSeries &a, const powerSeries &b) {
+	T t = 0;
+	T s = 0;
+	seriesAdd(a._series.data(), b._series.data(), _series.data(), shape::size, Ec<T>, t, s);
+	_error = a._error + b._error + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+	return *this;
+}
+
+template <typename T, int NVars, int Order>
+powerSeries<T, NVars, Order>& powerSeries<T, NVars, Order>::operator-=(const powerSeries &ps) {
+	T t = 0;
+	T s = 0;
+	seriesSub(_series.data(), ps._series.data(), _series.data(), shape::size, Ec<T>, t, s);
+	_error = _error - ps._error + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+	return *this;
+}
+
+template <typename T, int NVars, int Order>
+powerSeries<T, NVars, Order>& powerSeries<T, NVars, Order>::operator*=(const T &a) {
+	T t = 0;
+	T s = 0;
+	seriesScale(_series.data(), a, _series.data(), shape::size, Ec<T>, t, s);
+	_error = _error * a + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+	return *this;
+}
+
+template <typename T, int NVars, int Order>
+powerSeries<T, NVars, Order>& powerSeries<T, NVars, Order>::operator/=(const T &a) {
+	if (a == 0)
+		throw divideByZero();
+
+	T t = 0;
+	T s = 0;
+	seriesDiv(_series.data(), a, _series.data(), shape::size, Ec<T>, t, s);
+	_error = _error / a + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+	return *this;
+}
+
+template <typename T, int NVars, int Order>
+powerSeries<T, NVars, Order>& powerSeries<T, NVars, Order>::axpy(const powerSeries &u, const powerSeries &x, const T &a) {
+	T tx = 0, sx = 0;	// погрешность x * a
+	T t = 0, s = 0;		// погрешность суммы
+	seriesAxpy(u._series.data(), x._series.data(), a, _series.data(), shape::size, Ec<T>, tx, sx, t, s);
+
+	interval<T> xError = x._error * a + interval<T>(-tx, tx)*Em<T>*E + interval<T>(-sx, sx)*E;
+	_error = u._error + xError + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+	return *this;
+}
+
+// то же, что powerSeries<T>::mul с расписанием для рядов, упорядоченных по степени
+template <typename T, int NVars, int Order>
+powerSeries<T, NVars, Order>& powerSeries<T, NVars, Order>::mul(const powerSeries &a, const powerSeries &ps) {
+	if (this == &a || this == &ps)
+		return *this = a * ps;
+
+	_series.fill(0);
+	_error = interval<T>(0);
+	T t = 0;
+
+	// Jd[d] - сумма |ps[j]| по членам степени не ниже d
+	interval<T> Jd[Order + 2];
+	for (int d = Order; d >= 1; d--) {
+		interval<T> J = interval<T>(0, 0);
+		for (int j = _shape.orderStart[d]; j < _shape.orderStart[d + 1]; j++)
+			J += interval<T>(-mabs(ps._series[j]), mabs(ps._series[j]));
+		Jd[d] = Jd[d + 1] + J;
+	}
+
+	for (int i = 0; i < shape::size; i++) {
+		const T c = a._series[i];
+		if (c == 0)
+			continue;
+
+		const int start = _shape.multStart[i];
+		const int size = _shape.multStart[i + 1] - start;
+		const int *target = _shape.multTarget + start;
+		for (int j = 0; j < size; j++) {
+			T p = c * ps._series[j];
+			t += mabs(p);
+			t += (mabs(_series[target[j]]) > mabs(p)) ? mabs(_series[target[j]]) : mabs(p);
+			_series[target[j]] += p;
+		}
+	}
+
+	// члены со степенью выше Order - degree(i) уходят в J
+	for (int i = 0; i < shape::size; i++) {
+		if (a._series[i] != 0)
+			_error += interval<T>(-mabs(a._series[i]), mabs(a._series[i])) * (Jd[Order - _shape.degree[i] + 1] + ps._error);
+	}
+
+	interval<T> temp(0, 0);
+	for (int j = 0; j < shape::size; j++) {
+		if (ps._series[j] != 0)
+			temp += interval<T>(-mabs(ps._series[j]), mabs(ps._series[j]));
+	}
+	_error += a._error * (ps._error + temp);
+
+	T s = 0;
+	for (int k = 0; k < shape::size; k++)
+		s += flushToZero(_series[k], Ec<T>);
+	_error += interval<T>(-t, t)*E*Em<T> + interval<T>(-s, s)*E;
+
+	return *this;
+}
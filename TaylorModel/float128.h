@@ -0,0 +1,104 @@
+﻿/*
+Коэффициенты __float128 (IEEE 754 binary128, 113 бит мантиссы) для GCC и Clang; нужна библиотека libquadmath (-lquadmath).
+Операции над __float128 выполняются программно и округляются правильно, поэтому границы интервалов
+сдвигаются так же, как у double (outwardRounding), а Em<__float128> = 1e-33 (около 10u, u = 2^-113).
+Суммы для оценок при перемножении рядов копятся в double (см. precision.h): сравнение и сложение double
+в несколько раз дешевле, чем у __float128. MSVC __float128 не поддерживает, там файл ничего не объявляет.
+*/
+
+#pragma once
+#if defined(__SIZEOF_FLOAT128__)
+#include "interval.h"
+#include "precision.h"
+#include <quadmath.h>
+#include <limits>
+#include <ostream>
+
+
+// 2^e при компиляции (для numeric_limits)
+constexpr __float128 float128Power2(int e) {
+	__float128 r = 1, b = (e < 0) ? 0.5 : 2;
+	for (int n = (e < 0) ? -e : e; n; n >>= 1) {
+		if (n & 1)
+			r *= b;
+		if (n > 1)
+			b *= b;
+	}
+	return r;
+}
+
+namespace std {
+template <>
+class numeric_limits<__float128> {
+public:
+	static constexpr bool is_specialized = true;
+	static constexpr bool is_signed = true;
+	static constexpr bool is_integer = false;
+	static constexpr bool is_exact = false;
+	static constexpr bool has_infinity = true;
+	static constexpr bool has_quiet_NaN = true;
+	static constexpr bool has_signaling_NaN = true;
+	static constexpr bool is_iec559 = true;
+	static constexpr bool is_bounded = true;
+	static constexpr bool is_modulo = false;
+	static constexpr int radix = 2;
+	static constexpr int digits = 113;
+	static constexpr int digits10 = 33;
+	static constexpr int max_digits10 = 36;
+	static constexpr int min_exponent = -16381;
+	static constexpr int max_exponent = 16384;
+	static constexpr int min_exponent10 = -4931;
+	static constexpr int max_exponent10 = 4932;
+
+	static constexpr __float128 min() noexcept { return float128Power2(-16382); }
+	static constexpr __float128 max() noexcept { return (2 - float128Power2(-112)) * float128Power2(16383); }
+	static constexpr __float128 lowest() noexcept { return -max(); }
+	static constexpr __float128 epsilon() noexcept { return float128Power2(-112); }
+	static constexpr __float128 round_error() noexcept { return 0.5; }
+	static constexpr __float128 infinity() noexcept { return __builtin_inff128(); }
+	static constexpr __float128 quiet_NaN() noexcept { return __builtin_nanf128(""); }
+	static constexpr __float128 denorm_min() noexcept { return float128Power2(-16494); }
+};
+}
+
+
+template <>
+constexpr __float128 Em<__float128> = 1e-33;
+
+template <>
+constexpr __float128 Ec<__float128> = 1e-38;
+
+template <>
+struct precision<__float128> {
+	typedef double bound;
+
+	// double(|x|) отличается от |x| не больше чем на ulp / 2, умножение на 1 + 2^-52 округляется вверх не меньше чем на ulp
+	static inline bound magnitude(__float128 x) { return std::fabs((double)x) * (1 + std::numeric_limits<double>::epsilon()); }
+
+	static inline __float128 exp(__float128 x) { return expq(x); }
+	static inline __float128 sin(__float128 x) { return sinq(x); }
+	static inline __float128 cos(__float128 x) { return cosq(x); }
+	static inline __float128 sqrt(__float128 x) { return sqrtq(x); }
+	static inline __float128 nextafter(__float128 x, __float128 to) { return nextafterq(x, to); }
+};
+
+// как у double, но через fabsq: std::fabs для __float128 не перегружена
+template <>
+struct outwardRounding<__float128, true> {
+	static constexpr __float128 phi = std::numeric_limits<__float128>::epsilon() / 2 * (1 + std::numeric_limits<__float128>::epsilon());
+	static constexpr __float128 eta = std::numeric_limits<__float128>::denorm_min();
+
+	static inline __float128 step(__float128 c) {
+		const __float128 s = fabsq(c) * phi + eta;
+		return (s < std::numeric_limits<__float128>::max()) ? s : std::numeric_limits<__float128>::max();
+	}
+	static inline __float128 down(__float128 c) { return c - step(c); }
+	static inline __float128 up(__float128 c) { return c + step(c); }
+};
+
+// значение с точностью double (для графиков)
+inline std::ostream& operator<<(std::ostream &os, __float128 x) {
+	return os << (double)x;
+}
+
+#endif
@@ -1,5 +1,47 @@
-﻿#pragma once
+﻿/*
+Интервалы с направленным округлением границ.
+Для типов IEEE 754 (float, double) операция считается в обычном режиме округления к ближайшему,
+после чего нижняя граница сдвигается вниз, а верхняя вверх на величину не меньше ulp (outwardRounding).
+Режим округления процессора не переключается: коэффициенты рядов в kernels.h должны считаться
+с округлением к ближайшему, а переключение режима на каждом пакете операций дороже, чем сдвиг границ.
+Для double при наличии SSE2 (всегда на x64) умножение интервалов считается без ветвлений
+(при сборке с AVX компилятор использует те же команды в VEX-кодировке).
+*/
+
+#pragma once
 #include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INTERVAL_SSE2
+#endif
+
+
+/*
+Сдвиг результата операции наружу. Если c - ближайшее к точному результату x число, то down(c) <= x <= up(c):
+c -+ (phi |c| + eta), phi = u (1 + 2u), u = epsilon / 2, eta - наименьшее денормализованное число
+(S.M. Rump, P. Zimmermann, S. Boldo, G. Melquiond. Computing predecessor and successor in rounding
+to nearest, 2009). Шаг ограничен max(), чтобы бесконечные границы не превращались в NaN.
+Для остальных типов границы не сдвигаются.
+*/
+template <typename T, bool = std::numeric_limits<T>::is_iec559>
+struct outwardRounding {
+	static inline T down(T c) { return c; }
+	static inline T up(T c) { return c; }
+};
+
+template <typename T>
+struct outwardRounding<T, true> {
+	static constexpr T phi = std::numeric_limits<T>::epsilon() / 2 * (1 + std::numeric_limits<T>::epsilon());
+	static constexpr T eta = std::numeric_limits<T>::denorm_min();
+
+	static inline T step(T c) { return std::min(std::fabs(c) * phi + eta, std::numeric_limits<T>::max()); }
+	static inline T down(T c) { return c - step(c); }
+	static inline T up(T c) { return c + step(c); }
+};
+
 
 template <typename T>
 class interval {
@@ -7,6 +49,8 @@ private:
 	T _begin;
 	T _end;
 
+	typedef outwardRounding<T> rounding;
+
 public:
 	class divideByZero {};
 
@@ -47,82 +91,98 @@ bool interval<T>::operator==(const interval &rhs) const {
 
 template <typename T> inline
 interval<T>& interval<T>::operator+=(const interval &rhs) {
-	_begin += rhs._begin;
-	_end += rhs._end;
+	_begin = rounding::down(_begin + rhs._begin);
+	_end = rounding::up(_end + rhs._end);
 	return *this;
 }
 
 template <typename T> inline
 interval<T> interval<T>::operator+(const interval &rhs) const {
-	return interval(_begin + rhs._begin, _end + rhs._end);
+	return interval(rounding::down(_begin + rhs._begin), rounding::up(_end + rhs._end));
 }
 
 template <typename T> inline
 interval<T>& interval<T>::operator-=(const interval &rhs) {
-	_begin -= rhs._end;
-	_end -= rhs._begin;
+	const T begin = _begin - rhs._end;
+	_end = rounding::up(_end - rhs._begin);
+	_begin = rounding::down(begin);
 	return *this;
 }
 
 template <typename T> inline
 interval<T> interval<T>::operator-(const interval &rhs) const {
-	return interval(_begin - rhs._end, _end - rhs._begin);
+	return interval(rounding::down(_begin - rhs._end), rounding::up(_end - rhs._begin));
 }
 
 template <typename T> inline
 interval<T>& interval<T>::operator*=(const interval &rhs) {
-	T arr[] = { _begin*rhs._begin, _end*rhs._end, _begin*rhs._end, _end*rhs._begin };
-	_begin = *std::min_element(arr, arr + 4);
-	_end = *std::max_element(arr, arr + 4);
-	return *this;
+	return *this = *this * rhs;
 }
 
 template <typename T> inline
 interval<T> interval<T>::operator*(const interval &rhs) const {
 	T arr[] = { _begin*rhs._begin, _end*rhs._end, _begin*rhs._end, _end*rhs._begin };
-	return interval(*std::min_element(arr, arr + 4), *std::max_element(arr, arr + 4));
+	return interval(rounding::down(*std::min_element(arr, arr + 4)), rounding::up(*std::max_element(arr, arr + 4)));
 }
 
+#ifdef INTERVAL_SSE2
+// четыре произведения двумя mulpd, min / max по дорожкам, сдвиг обеих границ одной операцией
+template <> inline
+interval<double> interval<double>::operator*(const interval &rhs) const {
+	const __m128d a = _mm_set_pd(_end, _begin);
+	const __m128d b = _mm_set_pd(rhs._end, rhs._begin);
+	const __m128d p = _mm_mul_pd(a, b);								// (begin * begin', end * end')
+	const __m128d q = _mm_mul_pd(a, _mm_shuffle_pd(b, b, 1));		// (begin * end', end * begin')
+
+	__m128d lo = _mm_min_pd(p, q), hi = _mm_max_pd(p, q);
+	lo = _mm_min_sd(lo, _mm_unpackhi_pd(lo, lo));
+	hi = _mm_max_sd(hi, _mm_unpackhi_pd(hi, hi));
+	__m128d r = _mm_unpacklo_pd(lo, hi);
+
+	typedef outwardRounding<double> rd;
+	__m128d step = _mm_andnot_pd(_mm_set1_pd(-0.0), r);				// |r|
+	step = _mm_add_pd(_mm_mul_pd(step, _mm_set1_pd(rd::phi)), _mm_set1_pd(rd::eta));
+	step = _mm_min_pd(step, _mm_set1_pd(std::numeric_limits<double>::max()));
+	r = _mm_add_pd(r, _mm_xor_pd(step, _mm_set_pd(0.0, -0.0)));		// begin - step, end + step
+
+	return interval(_mm_cvtsd_f64(r), _mm_cvtsd_f64(_mm_unpackhi_pd(r, r)));
+}
+#endif
+
+// при t < 0 границы меняются местами
 template <typename T> inline
 interval<T>& interval<T>::operator*=(const T &t) {
-	_begin *= t;
-	_end *= t;
-	return *this;
+	return *this = *this * t;
 }
 
 template <typename T> inline
 interval<T> interval<T>::operator*(const T &t) const {
-	return interval(t * _begin, t * _end);
+	const T a = _begin * t, b = _end * t;
+	return interval(rounding::down(std::min(a, b)), rounding::up(std::max(a, b)));
 }
 
 
 template <typename T> inline
 interval<T>& interval<T>::operator/=(const interval &rhs) {
-	if (rhs._begin == 0 || rhs._end == 0) throw divideByZero();
-	T arr[] = { _begin / rhs._begin, _end / rhs._end, _begin / rhs._end, _end / rhs._begin };
-	_begin = *std::min_element(arr, arr + 4);
-	_end = *std::max_element(arr, arr + 4);
-	return *this;
+	return *this = *this / rhs;
 }
 
 template <typename T> inline
 interval<T> interval<T>::operator/(const interval &rhs) const {
 	if (rhs._begin == 0 || rhs._end == 0) throw divideByZero();
 	T arr[] = { _begin / rhs._begin, _end / rhs._end, _begin / rhs._end, _end / rhs._begin };
-	return interval(*std::min_element(arr, arr + 4), *std::max_element(arr, arr + 4));
+	return interval(rounding::down(*std::min_element(arr, arr + 4)), rounding::up(*std::max_element(arr, arr + 4)));
 }
 
 template <typename T> inline
 interval<T>& interval<T>::operator/=(const T &t) {
-	if (t == 0) throw divideByZero();
-	_begin /= t;
-	_end /= t;
-	return *this;
+	return *this = *this / t;
 }
 
 template <typename T> inline
 interval<T> interval<T>::operator/(const T &t) const {
 	if (t == 0) throw divideByZero();
-	return interval(_begin / t, _end / t);
+	const T a = _begin / t, b = _end / t;
+	return interval(rounding::down(std::min(a, b)), rounding::up(std::max(a, b)));
 }
 
@@ -0,0 +1,219 @@
+﻿/*
+Поэлементные операции над коэффициентами рядов.
+За один проход считается результат r, сумма t для оценки погрешности округления
+и сумма s модулей членов, которые меньше ec и потому обнуляются.
+Для double при сборке с AVX2 / AVX-512 используются векторные версии,
+иначе - обычный цикл. Векторные версии складывают t и s по одному члену в том же порядке,
+что и скалярные, поэтому оценка погрешности не зависит от сборки. Компилятор при этом не должен
+сливать умножение со сложением (FMA): MSVC /fp:precise так и делает, для GCC с -mfma / -mavx512f
+нужен -ffp-contract=off.
+*/
+
+#pragma once
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#define SERIES_SIMD
+#endif
+
+
+template <typename T>
+inline T mabs(T t) { return (t > 0) ? t : -t; }
+
+template <typename T>
+inline T flushToZero(T &r, T ec) {
+	if (mabs(r) < ec) {
+		T s = mabs(r);
+		r = 0;
+		return s;
+	}
+	return 0;
+}
+
+// r = a + b, t += max(|a|, |b|)
+template <typename T>
+void seriesAdd(const T *a, const T *b, T *r, int n, T ec, T &t, T &s) {
+	for (int i = 0; i < n; i++) {
+		t += (mabs(a[i]) > mabs(b[i])) ? mabs(a[i]) : mabs(b[i]);
+		r[i] = a[i] + b[i];
+		s += flushToZero(r[i], ec);
+	}
+}
+
+// r = a - b, t += max(|a|, |b|)
+template <typename T>
+void seriesSub(const T *a, const T *b, T *r, int n, T ec, T &t, T &s) {
+	for (int i = 0; i < n; i++) {
+		t += (mabs(a[i]) > mabs(b[i])) ? mabs(a[i]) : mabs(b[i]);
+		r[i] = a[i] - b[i];
+		s += flushToZero(r[i], ec);
+	}
+}
+
+// r = a * c, t += |r|
+template <typename T>
+void seriesScale(const T *a, T c, T *r, int n, T ec, T &t, T &s) {
+	for (int i = 0; i < n; i++) {
+		r[i] = a[i] * c;
+		t += mabs(r[i]);
+		s += flushToZero(r[i], ec);
+	}
+}
+
+// r = a / c, t += |r|
+template <typename T>
+void seriesDiv(const T *a, T c, T *r, int n, T ec, T &t, T &s) {
+	for (int i = 0; i < n; i++) {
+		r[i] = a[i] / c;
+		t += mabs(r[i]);
+		s += flushToZero(r[i], ec);
+	}
+}
+
+// r = u + x * c за один проход; tx, sx - для x * c, t, s - для суммы (как в operator* и operator+)
+template <typename T>
+void seriesAxpy(const T *u, const T *x, T c, T *r, int n, T ec, T &tx, T &sx, T &t, T &s) {
+	for (int i = 0; i < n; i++) {
+		T y = x[i] * c;
+		tx += mabs(y);
+		sx += flushToZero(y, ec);
+
+		t += (mabs(u[i]) > mabs(y)) ? mabs(u[i]) : mabs(y);
+		r[i] = u[i] + y;
+		s += flushToZero(r[i], ec);
+	}
+}
+
+
+#ifdef SERIES_SIMD
+
+#if defined(__AVX512F__)
+typedef __m512d vdouble;
+const int vsize = 8;
+
+inline vdouble vload(const double *p) { return _mm512_loadu_pd(p); }
+inline void vstore(double *p, vdouble x) { _mm512_storeu_pd(p, x); }
+inline vdouble vset(double x) { return _mm512_set1_pd(x); }
+inline vdouble vadd(vdouble x, vdouble y) { return _mm512_add_pd(x, y); }
+inline vdouble vsub(vdouble x, vdouble y) { return _mm512_sub_pd(x, y); }
+inline vdouble vmul(vdouble x, vdouble y) { return _mm512_mul_pd(x, y); }
+inline vdouble vdiv(vdouble x, vdouble y) { return _mm512_div_pd(x, y); }
+inline vdouble vmax(vdouble x, vdouble y) { return _mm512_max_pd(x, y); }
+inline vdouble vabs(vdouble x) { return _mm512_abs_pd(x); }
+
+// обнуление членов меньше ec; их модули (у остальных членов нули) - в flushed, false - обнулять нечего
+inline bool vflush(vdouble &r, vdouble ec, vdouble &flushed) {
+	vdouble ar = vabs(r);
+	__mmask8 small = _mm512_cmp_pd_mask(ar, ec, _CMP_LT_OQ);
+	flushed = _mm512_maskz_mov_pd(small, ar);
+	r = _mm512_mask_mov_pd(r, small, _mm512_setzero_pd());
+	return small != 0;
+}
+#else
+typedef __m256d vdouble;
+const int vsize = 4;
+
+inline vdouble vload(const double *p) { return _mm256_loadu_pd(p); }
+inline void vstore(double *p, vdouble x) { _mm256_storeu_pd(p, x); }
+inline vdouble vset(double x) { return _mm256_set1_pd(x); }
+inline vdouble vadd(vdouble x, vdouble y) { return _mm256_add_pd(x, y); }
+inline vdouble vsub(vdouble x, vdouble y) { return _mm256_sub_pd(x, y); }
+inline vdouble vmul(vdouble x, vdouble y) { return _mm256_mul_pd(x, y); }
+inline vdouble vdiv(vdouble x, vdouble y) { return _mm256_div_pd(x, y); }
+inline vdouble vmax(vdouble x, vdouble y) { return _mm256_max_pd(x, y); }
+inline vdouble vabs(vdouble x) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x); }
+
+inline bool vflush(vdouble &r, vdouble ec, vdouble &flushed) {
+	vdouble ar = vabs(r);
+	vdouble small = _mm256_cmp_pd(ar, ec, _CMP_LT_OQ);
+	flushed = _mm256_and_pd(small, ar);
+	r = _mm256_andnot_pd(small, r);
+	return _mm256_movemask_pd(small) != 0;
+}
+#endif
+
+// t += x[0], t += x[1], ... - по одной дорожке, как в скалярном цикле
+inline void vaccumulate(vdouble x, double &t) {
+	double lanes[vsize];
+	vstore(lanes, x);
+	for (int l = 0; l < vsize; l++)
+		t += lanes[l];
+}
+
+// то же для модулей обнулённых членов; прибавление нулей s не меняет, поэтому без обнулений s не трогаем
+inline void vaccumulate(vdouble flushed, bool any, double &s) {
+	if (any)
+		vaccumulate(flushed, s);
+}
+
+inline void seriesAdd(const double *a, const double *b, double *r, int n, double ec, double &t, double &s) {
+	const vdouble vec = vset(ec);
+	int i = 0;
+	for (; i + vsize <= n; i += vsize) {
+		vdouble x = vload(a + i), y = vload(b + i), sum = vadd(x, y), flushed;
+		vaccumulate(vmax(vabs(x), vabs(y)), t);
+		const bool any = vflush(sum, vec, flushed);
+		vaccumulate(flushed, any, s);
+		vstore(r + i, sum);
+	}
+	seriesAdd<double>(a + i, b + i, r + i, n - i, ec, t, s);
+}
+
+inline void seriesSub(const double *a, const double *b, double *r, int n, double ec, double &t, double &s) {
+	const vdouble vec = vset(ec);
+	int i = 0;
+	for (; i + vsize <= n; i += vsize) {
+		vdouble x = vload(a + i), y = vload(b + i), diff = vsub(x, y), flushed;
+		vaccumulate(vmax(vabs(x), vabs(y)), t);
+		const bool any = vflush(diff, vec, flushed);
+		vaccumulate(flushed, any, s);
+		vstore(r + i, diff);
+	}
+	seriesSub<double>(a + i, b + i, r + i, n - i, ec, t, s);
+}
+
+inline void seriesScale(const double *a, double c, double *r, int n, double ec, double &t, double &s) {
+	const vdouble vec = vset(ec), vc = vset(c);
+	int i = 0;
+	for (; i + vsize <= n; i += vsize) {
+		vdouble x = vmul(vload(a + i), vc), flushed;
+		vaccumulate(vabs(x), t);
+		const bool any = vflush(x, vec, flushed);
+		vaccumulate(flushed, any, s);
+		vstore(r + i, x);
+	}
+	seriesScale<double>(a + i, c, r + i, n - i, ec, t, s);
+}
+
+inline void seriesDiv(const double *a, double c, double *r, int n, double ec, double &t, double &s) {
+	const vdouble vec = vset(ec), vc = vset(c);
+	int i = 0;
+	for (; i + vsize <= n; i += vsize) {
+		vdouble x = vdiv(vload(a + i), vc), flushed;
+		vaccumulate(vabs(x), t);
+		const bool any = vflush(x, vec, flushed);
+		vaccumulate(flushed, any, s);
+		vstore(r + i, x);
+	}
+	seriesDiv<double>(a + i, c, r + i, n - i, ec, t, s);
+}
+
+inline void seriesAxpy(const double *u, const double *x, double c, double *r, int n, double ec,
+		double &tx, double &sx, double &t, double &s) {
+	const vdouble vec = vset(ec), vc = vset(c);
+	int i = 0;
+	for (; i + vsize <= n; i += vsize) {
+		vdouble y = vmul(vload(x + i), vc), flushed;
+		vaccumulate(vabs(y), tx);
+		bool any = vflush(y, vec, flushed);
+		vaccumulate(flushed, any, sx);
+
+		vdouble a = vload(u + i), sum = vadd(a, y);
+		vaccumulate(vmax(vabs(a), vabs(y)), t);
+		any = vflush(sum, vec, flushed);
+		vaccumulate(flushed, any, s);
+		vstore(r + i, sum);
+	}
+	seriesAxpy<double>(u + i, x + i, c, r + i, n - i, ec, tx, sx, t, s);
+}
+
+#endif
@@ -0,0 +1,76 @@
+﻿#include "mappedFile.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// если файла нет или он пустой, объект остаётся неоткрытым (isOpen() == false)
+#ifdef _WIN32
+mappedFile::mappedFile(const std::string &filename) : _data(nullptr), _size(0), _file(nullptr), _mapping(nullptr) {
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	_file = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		unmap();
+		return;
+	}
+
+	_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (_mapping != nullptr)
+		_data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (_data == nullptr) {
+		unmap();
+		return;
+	}
+	_size = (std::size_t)size.QuadPart;
+}
+
+void mappedFile::unmap() {
+	if (_data != nullptr)
+		UnmapViewOfFile(_data);
+	if (_mapping != nullptr)
+		CloseHandle(_mapping);
+	if (_file != nullptr)
+		CloseHandle(_file);
+	_data = nullptr;
+	_mapping = _file = nullptr;
+	_size = 0;
+}
+#else
+mappedFile::mappedFile(const std::string &filename) : _data(nullptr), _size(0) {
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0)
+		return;
+
+	struct stat st;
+	if (fstat(file, &st) == 0 && st.st_size > 0) {
+		void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, file, 0);
+		if (data != MAP_FAILED) {
+			_data = static_cast<const char*>(data);
+			_size = st.st_size;
+		}
+	}
+	close(file);	// отображение остаётся и после закрытия файла
+}
+
+void mappedFile::unmap() {
+	if (_data != nullptr)
+		munmap(const_cast<char*>(_data), _size);
+	_data = nullptr;
+	_size = 0;
+}
+#endif
+
+mappedFile::~mappedFile() {
+	unmap();
+}
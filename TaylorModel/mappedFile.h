@@ -0,0 +1,32 @@
+﻿/*
+Файл, отображённый в память только для чтения.
+Страницы такого файла общие для всех процессов, которые его открыли,
+поэтому большие таблицы (см. multSerCoef::save) не копируются в память каждого процесса.
+*/
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+
+class mappedFile {
+private:
+	const char *_data;		// nullptr - файл не открыт
+	std::size_t _size;
+#ifdef _WIN32
+	void *_file;
+	void *_mapping;
+#endif
+
+	void unmap();
+
+public:
+	explicit mappedFile(const std::string&);
+	~mappedFile();
+	mappedFile(const mappedFile&) = delete;
+	mappedFile& operator=(const mappedFile&) = delete;
+
+	inline bool isOpen() const { return _data != nullptr; }
+	inline const char* data() const { return _data; }
+	inline std::size_t size() const { return _size; }
+};
@@ -1,17 +1,25 @@
 ﻿#pragma once
 #include "series.h"
+#include "evaluator.h"
+#include "expression.h"
+#include "threadPool.h"
 #include <functional>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
 #include <math.h>
 using std::function;
 
 template <typename T>
 class equation {
+	template <typename> friend class equationBatch;	// ведёт ряды уравнений пакета сам (см. equationBatch::lockstep)
 
-	using mfunction = powerSeries<T>(equation<T>::*)(vector<powerSeries<T> > &);
+	// правая часть записывает результат во второй аргумент, который уже имеет нужную длину
+	using mfunction = void (equation<T>::*)(vector<powerSeries<T> > &, powerSeries<T> &);
 
 private:
-	multSerCoef *coef;
+	std::shared_ptr<multSerCoef> coef;	// может быть общей для нескольких уравнений (см. equationBatch)
 	vector<interval<T> > parameter;
 	vector<powerSeries<T> > u;
 	int sizeVar;		// сколько первых уравнений системы действительно считаем
@@ -19,15 +27,59 @@ private:
 	double h;
 	const double EPS = 0.000001;
 	std::ofstream fout;
+	std::unique_ptr<threadPool> workers;	// пусто - уравнения считаются последовательно
 
+	template <typename F> void forEachVar(const F&);
 
-	powerSeries<T> pFun1(vector<powerSeries<T> > &u);
-	powerSeries<T> pFun2(vector<powerSeries<T> > &u);
+	// ряды этапов метода Рунге-Кутты, заводятся один раз на весь расчёт
+	struct stageSeries {
+		vector<powerSeries<T> > K1, K2, K3, K4, v, w;
+	};
+	void initStages(stageSeries&);
+	void rungeKuttaStages(stageSeries&, double);
+
+	// интегрирование рядом Тейлора по времени (см. Picard): время - ещё один параметр ряда,
+	// внутри шага t = tStart + h * tau, tau из [0; 1]
+	std::shared_ptr<multSerCoef> timeCoef;
+	int timeVar;				// номер переменной tau в timeCoef
+	vector<int> spaceToTime;	// номер члена ряда u в таблице со временем
+	vector<int> timeToSpace;	// номер члена без tau в таблице u, -1 - член с фиктивной переменной
+	vector<vector<int> > tauSlice;	// члены таблицы со временем со степенью tau k - по возрастанию степени по остальным переменным
+	vector<vector<int> > sliceEnd;	// sliceEnd[k][d] - сколько первых членов tauSlice[k] имеют степень по остальным не выше d
+	vector<int> tauNext;			// тот же член с tau в степени на 1 больше, -1 - такого нет
+	struct picardSeries {
+		vector<powerSeries<T> > U;		// u в таблице со временем (на время вычисления правой части подменяет u)
+		vector<powerSeries<T> > P, Q, F;
+		vector<powerSeries<T> > slots;	// временные ряды графа правой части в таблице со временем
+
+		// для picardTaylor: граф правой части (пусто - P строится итерациями), ряды его узлов
+		// и вспомогательные ряды узлов (cos для sin, sin для cos, 1 / (2 sqrt) для sqrt, 1 / b для деления)
+		std::shared_ptr<const expressionGraph<T> > graph;
+		vector<powerSeries<T> > nodes, companion;
+		powerSeries<T> work;
+	};
+	void initTimeTable();
+	void initPicard(picardSeries&);
+	void toTime(const powerSeries<T>&, powerSeries<T>&);
+	void stepEnd(const powerSeries<T>&, powerSeries<T>&);
+	void picardMap(picardSeries&, double);
+	void sliceProduct(const powerSeries<T>&, const powerSeries<T>&, powerSeries<T>&, int, int, int, T, bool);
+	powerSeries<T>& taylorValue(picardSeries&, int);
+	void taylorNode(picardSeries&, int, int);
+	void picardTaylor(picardSeries&, double);
+	bool picardStep(picardSeries&, double, double&);
+
+
+	void pFun1(vector<powerSeries<T> > &u, powerSeries<T> &res);
+	void pFun2(vector<powerSeries<T> > &u, powerSeries<T> &res);
 
 
 	T startInterval(const T &begin, const T &end);
 	void findFirstPositionInSerie(vector<int> *vec);	
 
+	std::unique_ptr<seriesEvaluator<T> > evaluator;	// для printPoints, заводится при первом выводе
+	vector<T> values;
+
 	inline char nextState(char);
 	void searchPoints(vector<char>, int, int);
 	vector<T> statesToStatesT(vector<char>);
@@ -37,32 +89,94 @@ private:
 
 public:
 	class notSimetricStartInterval {};
+	class stepTooSmall {};
+	class remainderTooLarge {};
+	class wrongRHS {};
+
+	// шаг RungeKuttaAdaptive
+	struct stepInfo {
+		double t;			// начало шага
+		double h;
+		double estimate;	// оценка локальной погрешности
+		bool accepted;
+	};
+
+private:
+	vector<stepInfo> steps;
+	int wrapEvery = 0;		// через сколько шагов вызывать shrinkWrap, 0 - никогда
+	bool wrapAfterStep(int&);
+
+	T truncation = 0;		// порог setTruncation, 0 - члены не отбрасываются
+	vector<T> termBound;	// наибольший модуль члена с коэффициентом 1 на области определения
+	T domainBound(int) const;
+	void findTermBound();
+	T errorLimit = std::numeric_limits<T>::infinity();	// см. setErrorLimit
+	void checkErrorLimit() const;
+	void sweep(powerSeries<T>&);
+	void rhs(vector<powerSeries<T> >&, vector<powerSeries<T> >&);
+
+	std::shared_ptr<const expressionGraph<T> > graph;	// пусто - правая часть в pFun
+	vector<powerSeries<T> > graphSlots;				// временные ряды графа
+
+public:
 
 	vector<mfunction> pFun = { &equation<T>::pFun1, &equation<T>::pFun2 };
 
-	equation(int nvar, int param, int order) {
-		coef = new multSerCoef(nvar, param, order);		
+	equation(int nvar, int param, int order, bool graded = false)
+		: equation(std::make_shared<multSerCoef>(nvar, param, order, graded)) {};
+
+	// уравнение над уже посчитанной таблицей коэффициентов, таблица не копируется
+	explicit equation(const std::shared_ptr<multSerCoef> &table) : coef(table) {
 		sizeVar = coef->realVariable();
 		sizeParam = coef->realParameter();
 
 		for (int i = 0; i < sizeVar + sizeParam; i++)
-			u.push_back(powerSeries<T>(coef->serieSize(), coef));
-
-	};
+			u.push_back(powerSeries<T>(coef->serieSize(), coef.get()));
 
-	~equation() {
-		delete coef;
 	};
 
 
-	inline vector<powerSeries<T> > getODU() const;
-	inline powerSeries<T> getODU(int i) const;
+	inline const vector<powerSeries<T> >& getODU() const;
+	inline const powerSeries<T>& getODU(int i) const;
+	inline const std::shared_ptr<multSerCoef>& table() const { return coef; }
+	void setRHS(const expressionGraph<T>&);
+	void setRHS(const std::shared_ptr<const expressionGraph<T> >&);
 
+	void setThreads(int);
+	inline void setProductThreads(int threads) { coef->setThreads(threads); }
 	void initialFlow(vector<interval<T> >*);
 	void RungeKutta(double, double, double, bool = false, int = 0, std::string = "function.dat");
+	void RungeKuttaAdaptive(double, double, double, double, double = 1e-10, double = std::numeric_limits<double>::infinity());
+	void Picard(double, double, double, double = 1e-10);
+	inline const vector<stepInfo>& getSteps() const { return steps; }
+	bool shrinkWrap();
+	inline void setShrinkWrap(int steps) { wrapEvery = steps; }
+	inline void setTruncation(T eps) { truncation = eps; }
+	inline void setErrorLimit(T width) { errorLimit = width; }
+	interval<T> range(int) const;
+	void normalize();
 	void printPlot(std::string);
 };
 
+// Уравнения системы на каждом этапе Рунге-Кутты независимы, их можно считать в нескольких потоках.
+// Каждое уравнение всегда считается целиком одним потоком, поэтому результат от числа потоков не зависит.
+template <typename T>
+void equation<T>::setThreads(int threads) {
+	if (threads > 1)
+		workers.reset(new threadPool(threads));
+	else
+		workers.reset();
+}
+
+template <typename T>
+template <typename F>
+void equation<T>::forEachVar(const F &f) {
+	if (workers)
+		workers->run(sizeVar, f);
+	else
+		for (int i = 0; i < sizeVar; i++) f(i);
+}
+
 // для задания симметричного начального интервала на [-1; 1]
 template <typename T>
 T equation<T>::startInterval(const T &begin, const T &end) {
@@ -105,31 +219,211 @@ void equation<T>::initialFlow(vector<interval<T> > *points) {
 }
 
 template <typename T> 
-inline vector<powerSeries<T> > equation<T>::getODU() const {
+inline const vector<powerSeries<T> >& equation<T>::getODU() const {
 	return u;
 }
 
 template <typename T> 
-inline powerSeries<T> equation<T>::getODU(int i) const {
-	if (u.size() > i) 
-		return u[i];
+inline const powerSeries<T>& equation<T>::getODU(int i) const {
+	return u.at(i);
+}
+
+template <typename T>
+void equation<T>::pFun1(vector<powerSeries<T> > &v, powerSeries<T> &res) {
+	res = v[1];
 }
 
 template <typename T>
-powerSeries<T> equation<T>::pFun1(vector<powerSeries<T> > &v) {
-	return v[1];
+void equation<T>::pFun2(vector<powerSeries<T> > &v, powerSeries<T> &res) {
+	res.mul(v[0], v[0]);
 }
 
+// Правая часть из графа выражений (см. expression.h): переменные графа - переменные и параметры системы
+// в порядке initialFlow, выходы - уравнения. Граф копируется и компилируется, дальше pFun не используются.
 template <typename T>
-powerSeries<T> equation<T>::pFun2(vector<powerSeries<T> > &v) {
-	return v[0] * v[0];
+void equation<T>::setRHS(const expressionGraph<T> &g) {
+	auto compiled = std::make_shared<expressionGraph<T> >(g);
+	compiled->compile();
+	setRHS(std::shared_ptr<const expressionGraph<T> >(compiled));
 }
 
+// уже скомпилированный граф, может быть общим для нескольких уравнений (см. equationBatch)
 template <typename T>
-void equation<T>::RungeKutta(double tStart, double tEnd, double h, bool plot = false, int plotStep = 0, std::string filename = "function.dat") {
-	vector<powerSeries<T> > K1(sizeVar), K2(sizeVar), K3(sizeVar), K4(sizeVar), v(sizeVar);
-	int j, i, k = 0,
-		r = 1.0 / h / 2;
+void equation<T>::setRHS(const std::shared_ptr<const expressionGraph<T> > &g) {
+	if (g && (g->variables() != sizeVar + sizeParam || g->outputs() != sizeVar))
+		throw wrongRHS();
+
+	graph = g;
+	graphSlots.assign(graph ? graph->slots() : 0, powerSeries<T>(coef->serieSize(), coef.get()));
+}
+
+// res = f(v) для всех уравнений (параметры берутся из u);
+// при setTruncation пренебрежимые члены результата сразу уходят в погрешность
+template <typename T>
+void equation<T>::rhs(vector<powerSeries<T> > &v, vector<powerSeries<T> > &res) {
+	if (graph) {
+		graph->evaluate(v, u, res, graphSlots);
+		if (truncation > 0)
+			forEachVar([&](int i) { sweep(res[i]); });
+		return;
+	}
+
+	forEachVar([&](int i) {
+		(this->*pFun[i])(v, res[i]);
+		if (truncation > 0)
+			sweep(res[i]);
+	});
+}
+
+// наибольший модуль k-го члена с коэффициентом 1 на области определения
+template <typename T>
+T equation<T>::domainBound(int k) const {
+	T b = 1;
+	if ((int)parameter.size() < sizeVar + sizeParam)
+		return b;		// initialFlow ещё не вызывался, переменные считаем на [-1; 1]
+
+	for (int v = 0; v < sizeVar + sizeParam; v++) {
+		for (int p = coef->getVarOrder(k, v); p > 0; p--)
+			b *= std::max(mabs(parameter[v].begin()), mabs(parameter[v].end()));
+	}
+	return b;
+}
+
+template <typename T>
+void equation<T>::findTermBound() {
+	termBound.resize(coef->serieSize());
+	for (int k = 0; k < coef->serieSize(); k++)
+		termBound[k] = domainBound(k);
+}
+
+// оценка i-го уравнения на всей области начальных условий (вместе с остаточным интервалом)
+template <typename T>
+interval<T> equation<T>::range(int i) const {
+	seriesView<T> c = u.at(i).coefficients();
+	T center = 0;
+	T r = 0;
+	for (int k = 0; k < c.size(); k++) {
+		if (coef->getMultOrder(k) == 0)
+			center += c[k];
+		else
+			r += mabs(c[k]) * domainBound(k);
+	}
+	r += (r + mabs(center)) * Em<T> * E;
+	return interval<T>(center - r, center + r) + u[i].error();
+}
+
+// Переводит переменные и параметры с [-r; r] на [-1; 1] (x = r xi): ряды описывают те же функции,
+// но отброшенные при перемножении члены дальше оцениваются по настоящей области, а не по [-1; 1].
+template <typename T>
+void equation<T>::normalize() {
+	if ((int)parameter.size() < sizeVar + sizeParam)
+		return;
+
+	findTermBound();
+	for (int i = 0; i < sizeVar + sizeParam; i++) {
+		T t = 0;
+		T s = 0;
+		for (int k = 0; k < coef->serieSize(); k++) {
+			if (u[i][k] == 0)
+				continue;
+			u[i][k] *= termBound[k];
+			t += mabs(u[i][k]) * (coef->getMultOrder(k) + 1);	// не больше степени + 1 умножений
+			s += flushToZero(u[i][k], Ec<T>);
+		}
+		interval<T> error = u[i].error() + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+		u[i].error(error.begin(), error.end());
+	}
+
+	for (int v = 0; v < sizeVar + sizeParam; v++)
+		parameter[v] = interval<T>(-1, 1);
+	findTermBound();
+}
+
+// Если остаточный интервал какого-нибудь уравнения шире errorLimit, расчёт прерывается
+// исключением remainderTooLarge (так equationBatch::RungeKuttaSplit узнаёт, что область пора делить).
+template <typename T>
+void equation<T>::checkErrorLimit() const {
+	if (!(errorLimit < std::numeric_limits<T>::infinity()))
+		return;
+	for (int i = 0; i < sizeVar; i++) {
+		if (!(u[i].error().end() - u[i].error().begin() <= errorLimit))
+			throw remainderTooLarge();
+	}
+}
+
+/*
+Динамическое понижение порядка: члены, которые на области определения по модулю не больше
+truncation * (сумма модулей всех членов на области), уходят в погрешность ряда.
+Старшие степени при этом обычно пустеют, и перемножение таких рядов перебирает только
+ненулевые пары (см. powerSeries::mul), т.е. идёт как для ряда меньшего порядка.
+*/
+template <typename T>
+void equation<T>::sweep(powerSeries<T> &x) {
+	seriesView<T> c = x.coefficients();
+	T size = 0;
+	for (int k = 0; k < c.size(); k++)
+		size += mabs(c[k]) * termBound[k];
+	x.truncate(termBound, truncation * size);
+}
+
+template <typename T>
+void equation<T>::initStages(stageSeries &st) {
+	powerSeries<T> zero(coef->serieSize(), coef.get());
+	st.K1.assign(sizeVar, zero);
+	st.K2.assign(sizeVar, zero);
+	st.K3.assign(sizeVar, zero);
+	st.K4.assign(sizeVar, zero);
+	st.v.assign(u.begin(), u.begin() + sizeVar);
+	st.w.assign(sizeVar, zero);
+}
+
+// этапы K2..K4 и приращение w = (K1 + (K2 + K3) * 2 + K4) / 6 по уже посчитанному K1
+template <typename T>
+void equation<T>::rungeKuttaStages(stageSeries &st, double h) {
+	forEachVar([&](int j) { //v2 = u + K1 / 2
+		st.v[j].axpy(u[j], st.K1[j], 0.5);
+	});
+
+	rhs(st.v, st.K2); //k2
+	forEachVar([&](int i) {
+		st.K2[i] *= h;
+	});
+	forEachVar([&](int j) { //v3 = u + K2 / 2
+		st.v[j].axpy(u[j], st.K2[j], 0.5);
+	});
+
+	rhs(st.v, st.K3); //k3
+	forEachVar([&](int i) {
+		st.K3[i] *= h;
+	});
+	forEachVar([&](int j) { //v4 = u + K3
+		st.v[j].add(u[j], st.K3[j]);
+	});
+
+	rhs(st.v, st.K4); //k4
+	forEachVar([&](int i) {
+		st.K4[i] *= h;
+	});
+
+	forEachVar([&](int i) {
+		st.w[i].add(st.K2[i], st.K3[i]);
+		st.w[i] *= 2;
+		st.w[i] += st.K1[i];
+		st.w[i] += st.K4[i];
+		st.w[i] /= 6;
+	});
+}
+
+// Все ряды этапов заводятся до начала цикла и дальше меняются только на месте,
+// так что за шаг память не выделяется (см. allocationCount()).
+template <typename T>
+void equation<T>::RungeKutta(double tStart, double tEnd, double h, bool plot, int plotStep, std::string filename) {
+	stageSeries st;
+	initStages(st);
+	int k = 0,
+		r = 1.0 / h / 2,
+		wrapCount = 0;
+	findTermBound();
 	if (plot) {
 		fout.close();
 		fout.open(filename);
@@ -146,32 +440,719 @@ void equation<T>::RungeKutta(double tStart, double tEnd, double h, bool plot = f
 		k++;
 
 		// runge-kutta
-		for (i = 0; i < sizeVar; i++) //k1
-			K1[i] = (this->*pFun[i])(u) * h;
-		for (j = 0; j < sizeVar; j++) //v2
-			v[j] = u[j] + K1[j] / 2.0;
+		rhs(u, st.K1); //k1
+		forEachVar([&](int i) {
+			st.K1[i] *= h;
+		});
+		rungeKuttaStages(st, h);
+		forEachVar([&](int i) { // u = u + (K1 + (K2 + K3) * 2 + K4) / 6
+			u[i] += st.w[i];
+			if (truncation > 0)
+				sweep(u[i]);
+		});
+
+		tStart += h;
+		checkErrorLimit();
+		wrapAfterStep(wrapCount);
+	}
+
+	if (fout) fout.close();
+	return;
+}
+
+/*
+Метод Рунге-Кутты с выбором шага. Погрешность шага оценивается по вложенному методу 3-го порядка
+(K1 + 2 K2 + 2 K3 + K5) / 6, где K5 = h f(u + w) - это K1 следующего шага, поэтому
+на принятый шаг лишних вычислений правой части нет. Оценка - сумма модулей коэффициентов (K4 - K5) / 6,
+делённая на 1 + сумму модулей коэффициентов нового u, т.е. tol - относительная точность.
+Шаг отвергается, если оценка больше tol или если остаточный интервал какого-нибудь уравнения
+за шаг вырос больше чем вдвое (так раздувается погрешность в жёстких местах).
+Следующий шаг: h * 0.9 * (tol / оценка)^(1/4), но в пределах [h / 5; 5 h] и [hMin; hMax].
+Расчёт идёт ровно до tEnd. Все попытки шагов доступны через getSteps().
+*/
+template <typename T>
+void equation<T>::RungeKuttaAdaptive(double tStart, double tEnd, double h, double tol, double hMin, double hMax) {
+	const double safety = 0.9, minScale = 0.2, maxScale = 5;
 
-		for (i = 0; i < sizeVar; i++) //k2
-			K2[i] = (this->*pFun[i])(v) * h;
-		for (j = 0; j < sizeVar; j++) //v3
-			v[j] = u[j] + K2[j] / 2.0;
+	stageSeries st;
+	initStages(st);
+	vector<powerSeries<T> > next(st.v), F(st.w), nextF(st.w);	// F = f(u), nextF = f(next)
+	vector<double> estimate(sizeVar);
+	int wrapCount = 0;
+	steps.clear();
+	findTermBound();
 
-		for (i = 0; i < sizeVar; i++) //k3
-			K3[i] = (this->*pFun[i])(v) * h;
-		for (j = 0; j < sizeVar; j++) //v4
-			v[j] = u[j] + K3[j];
+	rhs(u, F);
 
-		for (i = 0; i < sizeVar; i++) //k4
-			K4[i] = (this->*pFun[i])(v) * h;
+	h = std::min(std::max(h, hMin), hMax);
+	while (tStart < tEnd - EPS) {
+		const double step = std::min(h, tEnd - tStart);
 
-		for (i = 0; i < sizeVar; i++)
-			u[i] = u[i] + (K1[i] + (K2[i] + K3[i]) * 2 + K4[i]) / 6;
+		forEachVar([&](int i) {
+			st.K1[i].scale(F[i], step);
+		});
+		rungeKuttaStages(st, step);
+		forEachVar([&](int i) {
+			next[i].add(u[i], st.w[i]);
+			if (truncation > 0)
+				sweep(next[i]);
+		});
 
-		tStart += h;
+		rhs(next, nextF);
+		forEachVar([&](int i) {
+			seriesView<T> k4 = st.K4[i].coefficients(), k5 = nextF[i].coefficients(), x = next[i].coefficients();
+			double e = 0, size = 1;
+			for (int k = 0; k < k4.size(); k++) {
+				e += (double)mabs(k4[k] - k5[k] * step);	// оценка шага считается в double при любом T
+				size += (double)mabs(x[k]);
+			}
+			estimate[i] = e / 6 / size;
+		});
+
+		double err = 0;
+		bool blowUp = false;
+		for (int i = 0; i < sizeVar; i++) {
+			err = (estimate[i] == estimate[i]) ? std::max(err, estimate[i]) : std::numeric_limits<double>::infinity();
+			double before = (double)(u[i].error().end() - u[i].error().begin()),
+				after = (double)(next[i].error().end() - next[i].error().begin());
+			if (!(after <= 2 * before + tol))
+				blowUp = true;
+		}
+
+		const bool accepted = (err <= tol && !blowUp);
+		steps.push_back({ tStart, step, err, accepted });
+
+		double scale = safety * pow(tol / err, 0.25);	// err = 0 -> inf
+		if (blowUp || !(scale >= minScale))
+			scale = minScale;
+		scale = std::min(scale, maxScale);
+
+		if (accepted) {
+			for (int i = 0; i < sizeVar; i++)
+				std::swap(u[i], next[i]);
+			F.swap(nextF);
+			tStart += step;
+
+			checkErrorLimit();
+			if (wrapAfterStep(wrapCount))
+				rhs(u, F);
+		}
+		else if (step <= hMin)
+			throw stepTooSmall();
+
+		h = std::min(std::max(step * scale, hMin), hMax);
 	}
+}
 
-	if (fout) fout.close();
-	return;
+////////////////////////////////////////////////
+//	shrink wrapping
+////////////////////////////////////////////////
+
+/*
+Поглощение остаточных интервалов многочленом (shrink wrapping, Berz - Makino).
+Переменные начальных условий x_j лежат в [-r_j; r_j] (см. initialFlow), в координатах xi_j = x_j / r_j
+u = c + L xi + N(xi) + I. Для A = L^-1 отображение S = A (u - c) = xi + N'(xi), где N' - нелинейная часть
+(и невязка A L - E). Если на кубе |xi| <= q константа Липшица N' равна s < 1 и q >= 1 + |A I| / (1 - s),
+то u(q xi) при |xi| <= 1 накрывает всё множество u(xi) + I, и остаточный интервал можно обнулить.
+Новые переменные - q xi на [-1; 1] (parameter меняется, параметры системы не трогаются), поэтому
+и отброшенные при перемножении члены дальше оцениваются точнее. После этого ряд описывает множество
+состояний, а не зависимость от начальной точки.
+false - L вырождена или нелинейная часть слишком велика, u не меняется.
+*/
+template <typename T>
+bool equation<T>::shrinkWrap() {
+	const int n = sizeVar, size = coef->serieSize();
+	const T margin = 1 + 1e-10;		// запас на округление при вычислении A, N' и q
+	if ((int)parameter.size() < sizeVar + sizeParam)
+		return false;
+
+	T eps = 0;
+	for (int i = 0; i < n; i++)
+		eps = std::max(eps, std::max(mabs(u[i].error().begin()), mabs(u[i].error().end())));
+	if (eps == 0)
+		return true;
+
+	// степень члена по переменным начальных условий и множитель перехода к xi
+	// (stateScale - только по переменным начальных условий)
+	vector<int> degree(size, 0);
+	vector<T> scale(size, 1), stateScale(size, 1);
+	for (int k = 0; k < size; k++) {
+		for (int v = 0; v < sizeVar + sizeParam; v++) {
+			const int e = coef->getVarOrder(k, v);
+			for (int p = 0; p < e; p++)
+				scale[k] *= parameter[v].end();
+			if (v < n) {
+				degree[k] += e;
+				for (int p = 0; p < e; p++)
+					stateScale[k] *= parameter[v].end();
+			}
+		}
+	}
+
+	// A = L^-1 методом Гаусса - Жордана с выбором главного элемента
+	vector<int> linear(n);
+	vector<vector<T> > L(n, vector<T>(n)), A(n, vector<T>(n, 0));
+	for (int j = 0; j < n; j++)
+		linear[j] = coef->getVarIndex(j);
+	for (int i = 0; i < n; i++) {
+		A[i][i] = 1;
+		for (int j = 0; j < n; j++)
+			L[i][j] = u[i][linear[j]] * scale[linear[j]];
+	}
+	vector<vector<T> > M(L);
+	for (int c = 0; c < n; c++) {
+		int pivot = c;
+		for (int i = c + 1; i < n; i++) {
+			if (mabs(M[i][c]) > mabs(M[pivot][c]))
+				pivot = i;
+		}
+		if (!(mabs(M[pivot][c]) > 0))
+			return false;
+		std::swap(M[c], M[pivot]);
+		std::swap(A[c], A[pivot]);
+
+		const T d = M[c][c];
+		for (int j = 0; j < n; j++) {
+			M[c][j] /= d;
+			A[c][j] /= d;
+		}
+		for (int i = 0; i < n; i++) {
+			if (i == c || M[i][c] == 0)
+				continue;
+			const T f = M[i][c];
+			for (int j = 0; j < n; j++) {
+				M[i][j] -= f * M[c][j];
+				A[i][j] -= f * A[c][j];
+			}
+		}
+	}
+
+	// |A I|
+	eps = 0;
+	for (int k = 0; k < n; k++) {
+		T e = 0;
+		for (int i = 0; i < n; i++)
+			e += mabs(A[k][i]) * std::max(mabs(u[i].error().begin()), mabs(u[i].error().end()));
+		eps = std::max(eps, e * margin);
+	}
+
+	// lip[k][d] - сумма |коэффициентов| k-й компоненты N' при членах степени d по xi
+	vector<vector<T> > lip(n, vector<T>(coef->order() + 1, 0));
+	for (int k = 0; k < n; k++) {
+		for (int m = 0; m < size; m++) {
+			if (degree[m] == 0)
+				continue;
+			T b = 0;
+			for (int i = 0; i < n; i++)
+				b += A[k][i] * u[i][m];
+			b *= scale[m];
+			for (int j = 0; j < n; j++) {
+				if (m == linear[j] && j == k)
+					b -= 1;
+			}
+			lip[k][degree[m]] += mabs(b);
+		}
+	}
+	auto lipschitz = [&](T q) {
+		T s = 0;
+		for (int k = 0; k < n; k++) {
+			T sk = 0, qd = 1;
+			for (int d = 1; d < (int)lip[k].size(); d++) {
+				sk += lip[k][d] * d * qd;
+				qd *= q;
+			}
+			s = std::max(s, sk * margin);
+		}
+		return s;
+	};
+
+	// наименьшее q = 1 + eps / (1 - s(q)), s(q) растёт вместе с q
+	T q = 1 + eps;
+	bool found = false;
+	for (int it = 0; it < 50 && !found; it++) {
+		const T s = lipschitz(q);
+		if (!(s < 1))
+			return false;
+		const T next = 1 + eps / (1 - s);
+		if (next <= q)
+			found = true;
+		else
+			q = 1 + (next - 1) * 1.01;
+	}
+	if (!found)
+		return false;
+
+	for (int i = 0; i < n; i++) {
+		T t = 0;
+		T s = 0;
+		for (int m = 0; m < size; m++) {
+			if (degree[m] == 0 || u[i][m] == 0)
+				continue;
+			T c = u[i][m] * stateScale[m];
+			for (int d = 0; d < degree[m]; d++)
+				c *= q;
+			u[i][m] = c;
+			t += mabs(c) * 2 * degree[m];	// не больше 2 degree[m] умножений
+			s += flushToZero(u[i][m], Ec<T>);
+		}
+		interval<T> error = interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+		u[i].error(error.begin(), error.end());
+	}
+	for (int j = 0; j < n; j++)
+		parameter[j] = interval<T>(-1, 1);
+	findTermBound();
+	return true;
+}
+
+template <typename T>
+bool equation<T>::wrapAfterStep(int &count) {
+	if (wrapEvery <= 0 || ++count % wrapEvery != 0)
+		return false;
+	return shrinkWrap();
+}
+
+////////////////////////////////////////////////
+//	Picard
+////////////////////////////////////////////////
+
+template <typename T>
+void equation<T>::initTimeTable() {
+	if (timeCoef)
+		return;
+
+	timeCoef = std::make_shared<multSerCoef>(coef->realVariable(), coef->realParameter() + 1, coef->order(), coef->graded());
+	timeVar = coef->realVariable() + coef->realParameter();
+
+	// члены сопоставляются по степеням настоящих переменных и параметров,
+	// члены с фиктивной переменной (если число переменных нечётное) всегда нулевые
+	auto fictive = [](const multSerCoef &c, int i, int from) {
+		for (int v = from; v < c.variableEven(); v++) {
+			if (c.getVarOrder(i, v) != 0)
+				return true;
+		}
+		return false;
+	};
+
+	std::map<vector<int>, int> index;
+	vector<int> key(timeVar);
+	for (int i = 0; i < coef->serieSize(); i++) {
+		if (fictive(*coef, i, timeVar))
+			continue;
+		for (int v = 0; v < timeVar; v++)
+			key[v] = coef->getVarOrder(i, v);
+		index[key] = i;
+	}
+
+	spaceToTime.assign(coef->serieSize(), -1);
+	timeToSpace.assign(timeCoef->serieSize(), -1);
+	for (int k = 0; k < timeCoef->serieSize(); k++) {
+		if (fictive(*timeCoef, k, timeVar + 1))
+			continue;
+		for (int v = 0; v < timeVar; v++)
+			key[v] = timeCoef->getVarOrder(k, v);
+
+		timeToSpace[k] = index[key];
+		if (timeCoef->getVarOrder(k, timeVar) == 0)
+			spaceToTime[timeToSpace[k]] = k;
+	}
+
+	// срезы по степени tau для picardTaylor; члены с фиктивной переменной в срезы не входят
+	const int order = timeCoef->order(), linear = timeCoef->getVarIndex(timeVar);
+	auto spaceOrder = [&](int k) { return timeCoef->getMultOrder(k) - timeCoef->getVarOrder(k, timeVar); };
+	tauSlice.assign(order + 1, vector<int>());
+	sliceEnd.assign(order + 1, vector<int>(order + 1, 0));
+	tauNext.assign(timeCoef->serieSize(), -1);
+	for (int k = 0; k < timeCoef->serieSize(); k++) {
+		if (timeToSpace[k] == -1)
+			continue;
+		tauSlice[timeCoef->getVarOrder(k, timeVar)].push_back(k);
+		if (linear != -1)
+			tauNext[k] = timeCoef->getMultIndex(k, linear);
+	}
+	for (int t = 0; t <= order; t++) {
+		std::stable_sort(tauSlice[t].begin(), tauSlice[t].end(), [&](int a, int b) { return spaceOrder(a) < spaceOrder(b); });
+		for (int k : tauSlice[t])
+			sliceEnd[t][spaceOrder(k)]++;
+		for (int d = 1; d <= order; d++)
+			sliceEnd[t][d] += sliceEnd[t][d - 1];
+	}
+}
+
+template <typename T>
+void equation<T>::initPicard(picardSeries &ps) {
+	powerSeries<T> zero(timeCoef->serieSize(), timeCoef.get());
+	ps.U.assign(sizeVar + sizeParam, zero);
+	ps.P.assign(sizeVar, zero);
+	ps.Q.assign(sizeVar, zero);
+	ps.F.assign(sizeVar, zero);
+	ps.slots.assign(graph ? graph->slots() : 0, zero);
+
+	// без графа (правая часть в pFun) P строится итерациями
+	ps.graph = graph;
+	ps.nodes.assign(ps.graph ? ps.graph->nodes() : 0, zero);
+	ps.companion.assign(ps.nodes.size(), zero);
+	ps.work = zero;
+}
+
+// ряд x (не зависящий от времени) в таблице со временем
+template <typename T>
+void equation<T>::toTime(const powerSeries<T> &x, powerSeries<T> &res) {
+	T fictive = 0;
+	for (int k = 0; k < timeCoef->serieSize(); k++)
+		res[k] = 0;
+	for (int i = 0; i < coef->serieSize(); i++) {
+		if (spaceToTime[i] != -1)
+			res[spaceToTime[i]] = x[i];
+		else
+			fictive += mabs(x[i]);
+	}
+	res.error(x.error().begin() - fictive, x.error().end() + fictive);
+}
+
+// значение ряда со временем в конце шага (tau = 1)
+template <typename T>
+void equation<T>::stepEnd(const powerSeries<T> &x, powerSeries<T> &res) {
+	T t = 0;
+	T s = 0;
+	T fictive = 0;
+	for (int i = 0; i < coef->serieSize(); i++)
+		res[i] = 0;
+	for (int k = 0; k < timeCoef->serieSize(); k++) {
+		if (timeToSpace[k] != -1) {
+			res[timeToSpace[k]] += x[k];
+			t += mabs(x[k]);
+		}
+		else
+			fictive += mabs(x[k]);
+	}
+	for (int i = 0; i < coef->serieSize(); i++)
+		s += flushToZero(res[i], Ec<T>);
+
+	interval<T> error = x.error() + interval<T>(-fictive, fictive) + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+	res.error(error.begin(), error.end());
+}
+
+// Q = u0 + интеграл h f(P) по tau от 0
+template <typename T>
+void equation<T>::picardMap(picardSeries &ps, double h) {
+	u.swap(ps.U);		// параметры в правой части берутся из u
+	try {
+		if (graph)
+			graph->evaluate(ps.P, u, ps.F, ps.slots);
+		forEachVar([&](int i) {
+			if (!graph)
+				(this->*pFun[i])(ps.P, ps.F[i]);
+			ps.F[i] *= h;
+			ps.Q[i].integrate(ps.F[i], timeVar);
+			ps.Q[i] += u[i];
+		});
+	}
+	catch (...) {
+		u.swap(ps.U);
+		throw;
+	}
+	u.swap(ps.U);
+}
+
+/*
+c += factor * сумма (weighted ? j : 1) * a_j * b_(k - j) по j из [from; to], где x_j - члены ряда x со степенью tau j.
+Перебираются только пары, произведение которых не выше порядка таблицы, поэтому все члены со степенью tau k
+стоят столько же, сколько одно перемножение рядов со временем по этим степеням. Погрешность не считается.
+*/
+template <typename T>
+void equation<T>::sliceProduct(const powerSeries<T> &a, const powerSeries<T> &b, powerSeries<T> &c,
+	int k, int from, int to, T factor, bool weighted) {
+	const int order = timeCoef->order();
+	seriesView<T> x = a.coefficients(), y = b.coefficients();
+	for (int j = from; j <= to; j++) {
+		const vector<int> &first = tauSlice[j], &second = tauSlice[k - j];
+		const vector<int> &end = sliceEnd[k - j];
+		const T w = weighted ? factor * j : factor;
+		for (int i : first) {
+			const int limit = order - k - (timeCoef->getMultOrder(i) - j);
+			if (limit < 0)
+				break;		// члены среза идут по возрастанию степени
+			if (x[i] == 0)
+				continue;
+
+			const T wx = w * x[i];
+			for (int q = 0; q < end[limit]; q++) {
+				const int index = timeCoef->getMultIndex(i, second[q]);
+				c.serie(index, c.coefficients()[index] + wx * y[second[q]]);
+			}
+		}
+	}
+}
+
+// ряд узла графа со всеми посчитанными степенями tau; переменные - P, параметры - U
+template <typename T>
+powerSeries<T>& equation<T>::taylorValue(picardSeries &ps, int n) {
+	const auto &x = ps.graph->at(n);
+	if (x.op != expressionGraph<T>::opVariable)
+		return ps.nodes[n];
+	return (x.a < sizeVar) ? ps.P[x.a] : ps.U[x.a];
+}
+
+// члены со степенью tau k ряда узла графа (и его вспомогательного ряда) по уже посчитанным младшим степеням
+template <typename T>
+void equation<T>::taylorNode(picardSeries &ps, int n, int k) {
+	auto value = [&](int m) -> powerSeries<T>& { return taylorValue(ps, m); };
+	const auto &x = ps.graph->at(n);
+	powerSeries<T> &r = ps.nodes[n], &c = ps.companion[n];
+	const powerSeries<T> &a = value(x.a);
+
+	// степень 0 - ряды без tau, считаются как в evaluate
+	if (k == 0) {
+		switch (x.op) {
+		case expressionGraph<T>::opAdd:
+			r.add(a, value(x.b));
+			break;
+		case expressionGraph<T>::opSub:
+			r = a;
+			r -= value(x.b);
+			break;
+		case expressionGraph<T>::opMul:
+			r.mul(a, value(x.b));
+			break;
+		case expressionGraph<T>::opScale:
+			r.scale(a, x.c);
+			break;
+		case expressionGraph<T>::opDiv:
+			r = a;
+			r /= x.c;
+			break;
+		case expressionGraph<T>::opShift:
+			r = a;
+			r.shift(x.c);
+			break;
+		case expressionGraph<T>::opExp:
+			r = exp(a);
+			break;
+		case expressionGraph<T>::opSin:
+			r = sin(a);
+			c = cos(a);
+			break;
+		case expressionGraph<T>::opCos:
+			r = cos(a);
+			c = sin(a);
+			break;
+		case expressionGraph<T>::opSqrt:
+			r = sqrt(a);
+			c.reciprocal(r);
+			c /= 2;
+			break;
+		case expressionGraph<T>::opReciprocal:
+			r.reciprocal(a);
+			break;
+		case expressionGraph<T>::opQuotient:
+			r = a / value(x.b);
+			c.reciprocal(value(x.b));
+			break;
+		default:
+			break;
+		}
+		return;
+	}
+
+	const vector<int> &slice = tauSlice[k];
+	seriesView<T> av = a.coefficients();
+	auto linear = [&](const auto &f) {
+		for (int i : slice)
+			r.serie(i, f(i));
+	};
+	// work - член со степенью k числителя рекуррентной формулы, r_k = work_k * c_0
+	auto divide = [&](const powerSeries<T> &inverse) {
+		sliceProduct(ps.work, inverse, r, k, k, k, 1, false);
+	};
+
+	switch (x.op) {
+	case expressionGraph<T>::opAdd: {
+		seriesView<T> bv = value(x.b).coefficients();
+		linear([&](int i) { return av[i] + bv[i]; });
+		break;
+	}
+	case expressionGraph<T>::opSub: {
+		seriesView<T> bv = value(x.b).coefficients();
+		linear([&](int i) { return av[i] - bv[i]; });
+		break;
+	}
+	case expressionGraph<T>::opMul:
+		sliceProduct(a, value(x.b), r, k, 0, k, 1, false);
+		break;
+	case expressionGraph<T>::opScale:
+		linear([&](int i) { return av[i] * x.c; });
+		break;
+	case expressionGraph<T>::opDiv:
+		linear([&](int i) { return av[i] / x.c; });
+		break;
+	case expressionGraph<T>::opShift:
+		linear([&](int i) { return av[i]; });
+		break;
+	case expressionGraph<T>::opExp:		// r' = a' r
+		sliceProduct(a, r, r, k, 1, k, T(1) / k, true);
+		break;
+	case expressionGraph<T>::opSin:		// r' = a' c, c' = -a' r (для cos r и c меняются местами)
+	case expressionGraph<T>::opCos: {
+		const T sign = (x.op == expressionGraph<T>::opSin) ? 1 : -1;
+		sliceProduct(a, c, r, k, 1, k, sign / k, true);
+		sliceProduct(a, r, c, k, 1, k, -sign / k, true);
+		break;
+	}
+	case expressionGraph<T>::opSqrt:	// 2 r_0 r_k = a_k - сумма r_j r_(k - j), j от 1 до k - 1
+		for (int i : slice)
+			ps.work.serie(i, av[i]);
+		sliceProduct(r, r, ps.work, k, 1, k - 1, -1, false);
+		divide(c);
+		break;
+	case expressionGraph<T>::opReciprocal:	// a_0 r_k = -сумма a_j r_(k - j), j от 1 до k
+		for (int i : slice)
+			ps.work.serie(i, 0);
+		sliceProduct(a, r, ps.work, k, 1, k, -1, false);
+		divide(r);
+		break;
+	case expressionGraph<T>::opQuotient: {	// b_0 r_k = a_k - сумма b_j r_(k - j), j от 1 до k
+		for (int i : slice)
+			ps.work.serie(i, av[i]);
+		sliceProduct(value(x.b), r, ps.work, k, 1, k, -1, false);
+		divide(c);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+/*
+Многочлен P шага длины h по степеням tau, как в методе рядов Тейлора: P_0 = u, P_(k + 1) = h f_k / (k + 1),
+где f_k - члены правой части со степенью tau k. Они зависят только от P_0, ..., P_k и считаются по узлам графа
+рекуррентными формулами, поэтому каждая степень добавляет только новые произведения. Это тот же многочлен,
+что и после order + 1 итераций Пикара, но за цену одного вычисления правой части.
+*/
+template <typename T>
+void equation<T>::picardTaylor(picardSeries &ps, double h) {
+	const expressionGraph<T> &g = *ps.graph;
+	for (int k = 0; k < timeCoef->order(); k++) {
+		for (int n : g.evaluationOrder())
+			taylorNode(ps, n, k);
+
+		const T factor = T(h) / (k + 1);
+		for (int i = 0; i < sizeVar; i++) {
+			const powerSeries<T> &f = taylorValue(ps, g.output(i));
+			for (int j : tauSlice[k]) {
+				if (tauNext[j] != -1)
+					ps.P[i].serie(tauNext[j], f[j] * factor);
+			}
+		}
+	}
+}
+
+/*
+Шаг длины h итерациями Пикара. Многочлен P строится по степеням tau (picardTaylor), а если правая часть
+задана не графом, а в pFun, - order + 1 итерациями без погрешности: каждая уточняет
+члены со следующей степенью tau, после них многочлен P больше не меняется.
+Затем проверяется погрешность: если отображение Пикара переводит P + I в P + R и R лежит в I,
+то решение на всём шаге лежит в P + R. I начинается с погрешности u и раздувается, пока проверка
+не пройдёт (не больше 10 попыток). width - наибольшая ширина R.
+false - проверка не прошла, u не меняется.
+*/
+template <typename T>
+bool equation<T>::picardStep(picardSeries &ps, double h, double &width) {
+	for (int i = 0; i < sizeVar + sizeParam; i++)
+		toTime(u[i], ps.U[i]);
+
+	for (int i = 0; i < sizeVar; i++) {
+		ps.P[i] = ps.U[i];
+		ps.P[i].error(0, 0);
+	}
+	if (ps.graph)
+		picardTaylor(ps, h);
+	for (int k = 0; k <= coef->order() && !ps.graph; k++) {
+		picardMap(ps, h);
+		for (int i = 0; i < sizeVar; i++) {
+			std::swap(ps.P[i], ps.Q[i]);
+			ps.P[i].error(0, 0);
+		}
+	}
+
+	vector<interval<T> > I(sizeVar), R(sizeVar);
+	for (int i = 0; i < sizeVar; i++)
+		I[i] = u[i].error();
+
+	bool verified = false;
+	for (int attempt = 0; attempt < 10 && !verified; attempt++) {
+		for (int i = 0; i < sizeVar; i++)
+			ps.P[i].error(I[i].begin(), I[i].end());
+		picardMap(ps, h);
+
+		verified = true;
+		for (int i = 0; i < sizeVar; i++) {
+			// Q - P: разница многочленов и погрешность Q
+			seriesView<T> q = ps.Q[i].coefficients(), p = ps.P[i].coefficients();
+			T d = 0;
+			for (int k = 0; k < q.size(); k++)
+				d += mabs(q[k] - p[k]);
+			d += d * Em<T> * E;
+			R[i] = ps.Q[i].error() + interval<T>(-d, d);
+
+			if (!(I[i].begin() <= R[i].begin() && R[i].end() <= I[i].end())) {
+				verified = false;
+				T w = (R[i].end() - R[i].begin()) / 2 + Em<T> * std::max(mabs(R[i].begin()), mabs(R[i].end()));
+				I[i] = interval<T>(std::min(I[i].begin(), R[i].begin()) - w, std::max(I[i].end(), R[i].end()) + w);
+			}
+		}
+	}
+	if (!verified)
+		return false;
+
+	width = 0;
+	for (int i = 0; i < sizeVar; i++) {
+		ps.P[i].error(R[i].begin(), R[i].end());
+		stepEnd(ps.P[i], u[i]);
+		if (truncation > 0)
+			sweep(u[i]);
+		width = std::max(width, (double)(R[i].end() - R[i].begin()));
+	}
+	return true;
+}
+
+// Интегрирование рядом Тейлора по времени с шагом h. Если погрешность на шаге не удаётся
+// проверить, шаг делится пополам (до hMin, дальше - исключение stepTooSmall), а после
+// growAfter проверенных шагов подряд снова удваивается, но не больше исходного h.
+// Шаги записываются в getSteps(), estimate - ширина остаточного интервала на шаге.
+template <typename T>
+void equation<T>::Picard(double tStart, double tEnd, double h, double hMin) {
+	const int growAfter = 3;
+	const double hMax = h;
+
+	initTimeTable();
+	picardSeries ps;
+	initPicard(ps);
+	int wrapCount = 0, verifiedRun = 0;
+	steps.clear();
+	findTermBound();
+
+	while (tStart < tEnd - EPS) {
+		const double step = std::min(h, tEnd - tStart);
+		double width = std::numeric_limits<double>::infinity();
+
+		const bool accepted = picardStep(ps, step, width);
+		steps.push_back({ tStart, step, width, accepted });
+		if (accepted) {
+			tStart += step;
+			checkErrorLimit();
+			wrapAfterStep(wrapCount);
+			if (++verifiedRun >= growAfter && h < hMax) {
+				h = std::min(2 * h, hMax);
+				verifiedRun = 0;
+			}
+		}
+		else if (step <= hMin)
+			throw stepTooSmall();
+		else {
+			h = std::max(step / 2, hMin);
+			verifiedRun = 0;
+		}
+	}
 }
 
 ////////////////////////////////////////////////
@@ -227,28 +1208,30 @@ vector<T> equation<T>::statesToStatesT(vector<char> states) {
 template <typename T>
 void equation<T>::printPoints(vector<char> states, int cur) {
 	vector<T> statesT = statesToStatesT(states);
-	T sum, p,
-		h = (parameter[cur].end() - parameter[cur].begin()) / 30.0;
-	int i = 0;
+	T h = (parameter[cur].end() - parameter[cur].begin()) / 30.0;
 
 	if (h == 0) return;
 
+	// все точки отрезка по переменной cur считаются разом (см. seriesEvaluator)
+	vector<vector<T> > points(statesT.size());
 	for (; statesT[cur] < parameter[cur].end() + EPS; statesT[cur] += h) {
-		for (i = 0; i < sizeVar; i++) {
-			sum = 0;
-
-			for (int j = 0; j < coef->serieSize(); j++) {	// сумма ряда для u[i]
-				p = 1;
-				for (int k = 0; k < coef->realVariable() + coef->realParameter(); k++) {
-					p *= pow(statesT[k], coef->orderTable[j][k]);
-				}
-				sum += u[i].serie(j) * p;
-			}
+		for (int k = 0; k < statesT.size(); k++)
+			points[k].push_back(statesT[k]);
+	}
 
-			fout << sum << " ";
-		}
+	if (!evaluator)
+		evaluator.reset(new seriesEvaluator<T>(coef.get()));
+	evaluator->setPoints(points);
+	const int n = evaluator->size();
+	values.resize(sizeVar * n);
+	for (int i = 0; i < sizeVar; i++)
+		evaluator->evaluate(u[i], values.data() + i * n);
+
+	for (int p = 0; p < n; p++) {
+		for (int i = 0; i < sizeVar; i++)
+			fout << values[i * n + p] << " ";
 		fout << "\n";
 	}
-	if (i != 0) fout << "\n";	// для нормального постороения в gnuplot
+	if (n != 0 && sizeVar != 0) fout << "\n";	// для нормального постороения в gnuplot
 	return;
 }
\ No newline at end of file
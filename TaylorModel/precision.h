@@ -0,0 +1,40 @@
+﻿/*
+Свойства типа коэффициентов рядов T.
+Em<T> - оценка сверху (с запасом) относительной погрешности одной операции над T,
+Ec<T> - порог, ниже которого коэффициенты обнуляются и уходят в остаточный интервал.
+precision<T> - функции от коэффициентов, которые нужны элементарным функциям от рядов (elementary.h),
+и тип bound, в котором копятся суммы модулей для оценок округления и отброшенных членов при перемножении рядов.
+От этих сумм нужна только граница сверху с относительной точностью около 1e-16, поэтому для типов
+повышенной точности (doubleDouble.h, float128.h) bound - double, а magnitude(x) >= |x| считается по старшей части.
+*/
+
+#pragma once
+#include <cmath>
+#include <limits>
+
+
+template <typename T>
+constexpr T Em = std::numeric_limits<T>::epsilon() * 5;
+
+template <>
+constexpr double Em<double> = 1e-15;
+
+template <typename T>
+constexpr T Ec = Em<T> * T(1e-5);
+
+template <>
+constexpr double Ec<double> = 1e-20;
+
+
+template <typename T>
+struct precision {
+	typedef T bound;
+
+	static inline bound magnitude(T x) { return (x > 0) ? x : -x; }
+
+	static inline T exp(T x) { return std::exp(x); }
+	static inline T sin(T x) { return std::sin(x); }
+	static inline T cos(T x) { return std::cos(x); }
+	static inline T sqrt(T x) { return std::sqrt(x); }
+	static inline T nextafter(T x, T to) { return std::nextafter(x, to); }
+};
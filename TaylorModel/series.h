@@ -8,49 +8,91 @@ N. Revol, K. Makino, M.Berz
 #pragma once
 #include "interval.h"
 #include "coefficients.h"
+#include "kernels.h"
+#include "precision.h"
+#include "doubleDouble.h"
+#include "float128.h"
+#include "allocator.h"
+#include <atomic>
 #include <vector>
 using std::vector;
 
-const double Em = 1e-15;
-const double Ec = 1e-20;
 const double E = 2;
 
-
+// просмотр коэффициентов ряда без копирования
 template <typename T>
-inline T mabs(T t) { return (t > 0) ? t : -t; }
+class seriesView {
+private:
+	const T *_data;
+	int _size;
+
+public:
+	seriesView(const T *data, int size) : _data(data), _size(size) {};
+
+	inline const T* begin() const { return _data; }
+	inline const T* end() const { return _data + _size; }
+	inline const T* data() const { return _data; }
+	inline int size() const { return _size; }
+	inline T operator[](int index) const { return _data[index]; }
+};
+
+// NVars и Order задаются только для рядов фиксированной формы (см. fixedSeries.h),
+// powerSeries<T> - ряд, форма которого задаётся таблицей multSerCoef при работе программы
+template <typename T, int NVars = 0, int Order = 0>
+class powerSeries;
 
 template <typename T>
-class powerSeries {
+class powerSeries<T, 0, 0> {
 private:
-	vector<T> _series;
+	seriesVector<T> _series;
 	interval<T> _error;
+	const multSerCoef *_coef;	// таблица, по которой построен ряд; у разных систем свои таблицы
+
+	// результат операции берёт память и таблицу там же, где и операнд
+	powerSeries(int size, const seriesAllocator<T> &alloc, const multSerCoef *coef)
+		: _series(size, 0, alloc), _error(interval<T>(0)), _coef(coef) {};
+
+	// суммы для оценок при перемножении (см. precision.h)
+	typedef typename precision<T>::bound bound;
+	static inline bound magnitude(const T &x) { return precision<T>::magnitude(x); }
+
+	bound mulRows(const powerSeries&, const powerSeries&, const seriesVector<int>&);
+	bound mulGather(const powerSeries&, const powerSeries&);
+
+	static std::atomic<long long> _copiedBytes;
+	inline void countCopy() { _copiedBytes += _series.size() * sizeof(T); }
 
 public:
-	static multSerCoef *_coef;
 	class notTheSameLength {};
+	class notTheSameTable {};
 	class outOfRange {};
 	class divideByZero {};
+	class outOfDomain {};		// аргумент вне области определения функции (см. elementary.h)
 
-	powerSeries() : _error(interval<T>(0)) {};
-	powerSeries(int size, multSerCoef *coef) {
-		_series.resize(size);
-		_coef = coef;
+	powerSeries() : _error(interval<T>(0)), _coef(nullptr) {};
+	powerSeries(int size, const multSerCoef *coef)
+		: _series(size, 0, seriesAllocator<T>(coef->pool())), _error(interval<T>(0)), _coef(coef) {};
 
-		for (int i = 0; i < size; i++) _series[i] = 0;
-		_error = interval<T>(0);
-	}
+	powerSeries(const powerSeries &ps) : _series(ps._series), _error(ps._error), _coef(ps._coef) { countCopy(); }
+	powerSeries(powerSeries&&) = default;
 
 	~powerSeries() {};
 
-	inline vector<T> serie() const { return _series; }
+	// сколько байт коэффициентов скопировано при копировании рядов с начала работы программы
+	static long long copiedBytes() { return _copiedBytes.load(); }
+
+	inline seriesView<T> coefficients() const { return seriesView<T>(_series.data(), _series.size()); }
+	inline vector<T> serie() const { return vector<T>(_series.begin(), _series.end()); }	// копия, см. coefficients()
 	inline T serie(int index) const { return _series[index]; }
 	inline void serie(int index, T t) { _series[index] = t; }
 
+	inline const multSerCoef* table() const { return _coef; }
 	inline interval<T> error() const { return _error; }
-	inline void error(T begin, T end) { _error._begin = begin; _error._end = end; }
+	inline void error(T begin, T end) { _error = interval<T>(begin, end); }
 
 
 	powerSeries& operator=(const powerSeries &ps);
+	powerSeries& operator=(powerSeries&&) = default;
 
 
 	inline T operator[](int index) const { return _series[index]; }
@@ -67,27 +109,65 @@ public:
 	powerSeries& operator-=(const powerSeries&);
 	powerSeries operator-(const powerSeries&) const;
 
+	powerSeries& operator*=(const T&);
 	powerSeries operator*(const T&) const;
 	powerSeries operator*(const powerSeries &ps) const;
 
-
+	powerSeries& operator/=(const T&);
 	powerSeries operator/(const T &a) const;
-
+	powerSeries& operator/=(const powerSeries&);
+	powerSeries operator/(const powerSeries&) const;
+
+	// операции без выделения памяти (ряд уже должен иметь нужную длину)
+	powerSeries& add(const powerSeries&, const powerSeries&);	// *this = a + b
+	powerSeries& scale(const powerSeries&, const T&);			// *this = x * a
+	powerSeries& axpy(const powerSeries&, const T&);			// *this = *this + x * a
+	powerSeries& axpy(const powerSeries&, const powerSeries&, const T&);	// *this = u + x * a
+	powerSeries& mul(const powerSeries&, const powerSeries&);	// *this = a * b
+	powerSeries& shift(const T&);								// *this = *this + c
+	powerSeries& reciprocal(const powerSeries&);				// *this = 1 / x
+	powerSeries& integrate(const powerSeries&, int);			// *this = интеграл x по переменной var
+	powerSeries& truncate(const vector<T>&, T);	// члены не больше eps на области определения - в погрешность
+
+	void nonZero(seriesVector<int>*) const;
+	int degree() const;		// наибольшая степень ненулевого члена (рабочий порядок ряда)
 };
 
 
-template <typename T> multSerCoef *powerSeries<T>::_coef;
+template <typename T> std::atomic<long long> powerSeries<T>::_copiedBytes(0);
 
 template <typename T>
 powerSeries<T>& powerSeries<T>::operator=(const powerSeries &ps) {
 	if (this != &ps) {
 		_error = ps._error;
-		_series.resize(ps._series.size());
 		_series = ps._series;
+		_coef = ps._coef;
+		countCopy();
 	}
 	return *this;
 }
 
+// номера ненулевых членов ряда
+template <typename T>
+void powerSeries<T>::nonZero(seriesVector<int> *vec) const {
+	vec->clear();
+	vec->reserve(_series.size());
+	for (int i = 0; i < _series.size(); i++) {
+		if (_series[i] != 0)
+			vec->push_back(i);
+	}
+}
+
+template <typename T>
+int powerSeries<T>::degree() const {
+	int d = 0;
+	for (int i = 0; i < _series.size(); i++) {
+		if (_series[i] != 0)
+			d = std::max(d, _coef->getMultOrder(i));
+	}
+	return d;
+}
+
 template <typename T>
 powerSeries<T>& powerSeries<T>::operator+=(const powerSeries &ps) {
 	if (_series.size() != ps._series.size())
@@ -95,16 +175,8 @@ powerSeries<T>& powerSeries<T>::operator+=(const powerSeries &ps) {
 
 	T t = 0;
 	T s = 0;
-	for (int i = 0; i < _series.size(); i++) {
-		t += (mabs(_series[i]) > mabs(ps._series[i])) ? mabs(_series[i]) : mabs(ps._series[i]);
-		_series[i] += ps._series[i];
-
-		if (mabs(_series[i]) < Ec) {
-			s += mabs(_series[i]);
-			_series[i] = 0;
-		}
-	}
-	_error += ps._error + interval<T>(-t, t)*Em*E + interval<T>(-s, s)*E;
+	seriesAdd(_series.data(), ps._series.data(), _series.data(), _series.size(), Ec<T>, t, s);
+	_error = _error + ps._error + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;	// как в operator+
 	return *this;
 }
 
@@ -115,17 +187,9 @@ powerSeries<T> powerSeries<T>::operator+(const powerSeries &ps) const {
 
 	T t = 0;
 	T s = 0;
-	powerSeries sum;
-	for (int i = 0; i < _series.size(); i++) {
-		t += (mabs(_series[i]) > mabs(ps._series[i])) ? mabs(_series[i]) : mabs(ps._series[i]);
-		sum._series.push_back(_series[i] + ps._series[i]);
-
-		if (mabs(sum._series[i]) < Ec) {
-			s += mabs(_series[i]);
-			sum._series[i] = 0;
-		}
-	}
-	sum._error = _error + ps._error + interval<T>(-t, t)*Em*E + interval<T>(-s, s)*E;
+	powerSeries sum(_series.size(), _series.get_allocator(), _coef);
+	seriesAdd(_series.data(), ps._series.data(), sum._series.data(), _series.size(), Ec<T>, t, s);
+	sum._error = _error + ps._error + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
 	return sum;
 }
 
@@ -136,17 +200,8 @@ powerSeries<T>& powerSeries<T>::operator-=(const powerSeries &ps) {
 
 	T t = 0;
 	T s = 0;
-	for (int i = 0; i < _series.size(); i++) {
-		t += (mabs(_series[i]) > mabs(ps._series[i])) ? mabs(_series[i]) : mabs(ps._series[i]);
-		_series[i] -= ps._series[i];
-
-		if (mabs(_series[i]) < Ec) {
-			s += mabs(_series[i]);
-			_series[i] = 0;
-		}
-	}
-
-	_error -= ps._error + interval<T>(-t, t)*Em*E + interval<T>(-s, s)*E;
+	seriesSub(_series.data(), ps._series.data(), _series.data(), _series.size(), Ec<T>, t, s);
+	_error = _error - ps._error + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;	// как в operator-
 	return *this;
 }
 
@@ -157,106 +212,448 @@ powerSeries<T> powerSeries<T>::operator-(const powerSeries &ps) const {
 
 	T t = 0;
 	T s = 0;
-	powerSeries sub;
-	for (int i = 0; i < _series.size(); i++) {
-		t += (mabs(_series[i]) > mabs(ps._series[i])) ? mabs(_series[i]) : mabs(ps._series[i]);
-		sub._series.push_back(_series[i] - ps._series[i]);
-
-		if (mabs(sub._series[i]) < Ec) {
-			s += mabs(sub._series[i]);
-			sub._series[i] = 0;
-		}
-	}
-
-	sub._error = _error - ps._error + interval<T>(-t, t)*Em*E + interval<T>(-s, s)*E;
+	powerSeries sub(_series.size(), _series.get_allocator(), _coef);
+	seriesSub(_series.data(), ps._series.data(), sub._series.data(), _series.size(), Ec<T>, t, s);
+	sub._error = _error - ps._error + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
 	return sub;
 }
 
 template <typename T>
-powerSeries<T> powerSeries<T>::operator*(const T &a) const {
+powerSeries<T>& powerSeries<T>::operator*=(const T &a) {
 	T t = 0;
 	T s = 0;
+	seriesScale(_series.data(), a, _series.data(), _series.size(), Ec<T>, t, s);
+	_error = _error * a + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+	return *this;
+}
 
-	powerSeries ps;
-	for (int i = 0; i < _series.size(); i++) {
-		ps._series.push_back(_series[i] * a);
-		t += ps._series[i];
+template <typename T>
+powerSeries<T> powerSeries<T>::operator*(const T &a) const {
+	T t = 0;
+	T s = 0;
 
-		if (mabs(ps._series[i]) < Ec) {
-			s += mabs(ps._series[i]);
-			ps._series[i] = 0;
-		}
-	}
-	ps._error = _error * a + interval<T>(-t, t)*Em*E + interval<T>(-s, s)*E;
+	powerSeries ps(_series.size(), _series.get_allocator(), _coef);
+	seriesScale(_series.data(), a, ps._series.data(), _series.size(), Ec<T>, t, s);
+	ps._error = _error * a + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
 
 	return ps;
 }
 
 template <typename T>
 powerSeries<T> powerSeries<T>::operator*(const powerSeries &ps) const {
-	powerSeries mul(_series.size(), _coef);
+	powerSeries res(_series.size(), _series.get_allocator(), _coef);
+	res.mul(*this, ps);
+	return res;
+}
+
+template <typename T>
+powerSeries<T>& powerSeries<T>::mul(const powerSeries &a, const powerSeries &ps) {
+	if (this == &a || this == &ps)
+		return *this = a * ps;
+	if (a._series.size() != ps._series.size())
+		throw notTheSameLength();
+	if (a._coef != ps._coef)
+		throw notTheSameTable();
+
+	_coef = a._coef;
+	_series.assign(a._series.size(), 0);
+	_error = interval<T>(0);
 	T p = 0;
-	T t = 0;
+	bound t = 0;
 	int index;
 
-	for (int i = 0; i < _series.size(); i++) {
-		interval<T> J = interval<T>(0, 0);
-
-		for (int j = 0; j < _series.size(); j++) {
+	// перебираем только ненулевые члены: нулевое произведение складывается точно,
+	// в J и temp нулевые коэффициенты вклада не дают.
+	// Служебные массивы свои у каждого потока и после первого умножения не перевыделяются
+	static thread_local seriesVector<int> nz1, nz2;
+	a.nonZero(&nz1);
+	ps.nonZero(&nz2);
+
+	// Если ненулевых пар намного меньше, чем пар в строках расписания (например, после truncate
+	// старшие степени пустые), перебираем только ненулевые пары. Пары складываются в том же порядке,
+	// поэтому коэффициенты произведения те же, меньше только оценка округления (без нулевых слагаемых).
+	// От числа потоков выбор не зависит, разреженное перемножение всегда идёт в одном потоке.
+	bool sparse = false;
+	if (_coef->hasMultSchedule()) {
+		long long rows = 0;
+		for (int i : nz1)
+			rows += _coef->multStart(i + 1) - _coef->multStart(i);
+		sparse = (long long)nz1.size() * (long long)nz2.size() * 2 < rows;
+	}
 
-			if ((index = _coef->getMultIndex(i, j)) != -1) {
-				p = _series[i] * ps._series[j];
-				t += mabs(p);
-				t += (mabs(mul._series[index]) > mabs(p))	? mabs(mul._series[index]) : mabs(p);
-				mul._series[index] += p;
+	if (_coef->hasMultSchedule() && !sparse) {
+		// Jd[d] - сумма |ps[j]| по членам степени не ниже d. Суммы неотрицательных чисел считаются
+		// без интервалов (в bound), а погрешность их округления (меньше size * epsilon от суммы) добавляется один раз
+		static thread_local seriesVector<bound> Js;
+		static thread_local seriesVector<interval<T> > Jd;
+		Js.assign(_coef->order() + 2, 0);
+		if (_coef->graded()) {
+			// члены упорядочены по степени: члены с номера orderStart(d) и до конца ряда
+			for (int d = _coef->order(); d >= 1; d--) {
+				bound J = 0;
+				for (int j = _coef->orderStart(d); j < _coef->orderStart(d + 1); j++)
+					J += magnitude(ps._series[j]);
+				Js[d] = Js[d + 1] + J;
 			}
-			else {
-				J += interval<T>(-mabs(ps._series[j]), mabs(ps._series[j]));
+		}
+		else {
+			// в порядке возрастания j, как и без расписания
+			for (int j : nz2) {
+				for (int d = 1; d <= _coef->getMultOrder(j); d++)
+					Js[d] += magnitude(ps._series[j]);
+			}
+		}
+		const bound grow = 1 + (_series.size() + 2) * std::numeric_limits<bound>::epsilon();
+		Jd.resize(Js.size());
+		for (int d = 0; d < Js.size(); d++)
+			Jd[d] = interval<T>(T(-Js[d] * grow), T(Js[d] * grow));
+
+		if (_coef->workers())
+			t = mulGather(a, ps);
+		else
+			t = mulRows(a, ps, nz1);
+
+		// члены со степенью от multOverflow(i) уходят в J
+		for (int i : nz1)
+			_error += interval<T>(-mabs(a._series[i]), mabs(a._series[i])) * (Jd[_coef->multOverflow(i)] + ps._error);
+	}
+	else {
+		for (int i : nz1) {
+			interval<T> J = interval<T>(0, 0);
+
+			for (int j : nz2) {
+
+				if ((index = _coef->getMultIndex(i, j)) != -1) {
+					p = a._series[i] * ps._series[j];
+					const bound mp = magnitude(p), mr = magnitude(_series[index]);
+					t += mp;
+					t += (mr > mp) ? mr : mp;
+					_series[index] += p;
+				}
+				else {
+					J += interval<T>(-mabs(ps._series[j]), mabs(ps._series[j]));
+				}
 			}
+			_error += interval<T>(-mabs(a._series[i]), mabs(a._series[i])) * (J + ps._error);
 		}
-		mul._error += interval<T>(-mabs(_series[i]), mabs(_series[i])) * (J + ps._error);
 	}
 
 	interval<T> temp(0, 0);
-	for (int j = 0; j < _series.size(); j++) {
+	for (int j : nz2) {
 		temp += interval<T>(-mabs(ps._series[j]), mabs(ps._series[j]));
 	}
-	mul._error += _error * (ps._error + temp);
+	_error += a._error * (ps._error + temp);
 
 	T s = 0;
 	for (int k = 0; k < _series.size(); k++) {
-		if (mabs(mul._series[k]) < Ec) {
-			s += mabs(mul._series[k]);
-			mul._series[k] = 0;
+		if (mabs(_series[k]) < Ec<T>) {
+			s += mabs(_series[k]);
+			_series[k] = 0;
 		}
 	}
-	mul._error += interval<T>(-t, t)*E*Em + interval<T>(-s, s)*E;
+	_error += interval<T>(T(-t), T(t))*E*Em<T> + interval<T>(-s, s)*E;
 
-	return mul;
+	return *this;
 }
 
+// Сложение произведений по строкам расписания: i-й член a на все подходящие члены b.
+// Возвращает сумму для оценки погрешности округления.
 template <typename T>
-powerSeries<T> powerSeries<T>::operator/(const T &a) const {
-	if (a == 0)
-		throw divideByZero();
+typename powerSeries<T>::bound powerSeries<T>::mulRows(const powerSeries &a, const powerSeries &ps, const seriesVector<int> &nz1) {
+	const int *multIndex = _coef->multIndex();
+	const int *multTarget = _coef->multTarget();
+	const T *b = ps._series.data();
+	T p = 0;
+	bound t = 0;
+
+	for (int i : nz1) {
+		const T c = a._series[i];
+		const int start = _coef->multStart(i);
+		const int size = _coef->multStart(i + 1) - start;
+		const int *target = multTarget + start;
+
+		if (_coef->graded()) {
+			// множители - префикс ряда
+			for (int j = 0; j < size; j++) {
+				p = c * b[j];
+				const bound mp = magnitude(p), mr = magnitude(_series[target[j]]);
+				t += mp;
+				t += (mr > mp) ? mr : mp;
+				_series[target[j]] += p;
+			}
+		}
+		else {
+			const int *index = multIndex + start;
+			for (int j = 0; j < size; j++) {
+				p = c * b[index[j]];
+				const bound mp = magnitude(p), mr = magnitude(_series[target[j]]);
+				t += mp;
+				t += (mr > mp) ? mr : mp;
+				_series[target[j]] += p;
+			}
+		}
+	}
+	return t;
+}
 
+// То же в нескольких потоках: каждый член произведения целиком собирает один поток,
+// пары (i, j) складываются в том же порядке, что и в mulRows, поэтому коэффициенты совпадают.
+// Сумма для оценки погрешности считается по блокам и складывается в порядке блоков,
+// так что результат не зависит от числа потоков.
+template <typename T>
+typename powerSeries<T>::bound powerSeries<T>::mulGather(const powerSeries &a, const powerSeries &ps) {
+	static thread_local seriesVector<bound> blockT;
+	blockT.assign(_coef->gatherBlocks(), 0);
+
+	const int *row = _coef->gatherRow();
+	const int *col = _coef->gatherCol();
+	const T *x = a._series.data();
+	const T *y = ps._series.data();
+	T *res = _series.data();
+	const multSerCoef *coef = _coef;
+	bound *bt = blockT.data();
+
+	coef->workers()->run(coef->gatherBlocks(), [=](int block) {
+		bound t = 0;
+		for (int k = coef->gatherBlock(block); k < coef->gatherBlock(block + 1); k++) {
+			T sum = 0;
+			for (int q = coef->gatherStart(k); q < coef->gatherStart(k + 1); q++) {
+				if (x[row[q]] == 0)	// как и в mulRows, нулевые члены a пропускаются
+					continue;
+				T p = x[row[q]] * y[col[q]];
+				const bound mp = magnitude(p), ms = magnitude(sum);
+				t += mp;
+				t += (ms > mp) ? ms : mp;
+				sum += p;
+			}
+			res[k] = sum;
+		}
+		bt[block] = t;
+	});
+
+	bound t = 0;
+	for (bound b : blockT)
+		t += b;
+	return t;
+}
+
+// то же, что *this = a + b, но без временного ряда
+template <typename T>
+powerSeries<T>& powerSeries<T>::add(const powerSeries &a, const powerSeries &b) {
+	if (a._series.size() != b._series.size())
+		throw notTheSameLength();
+
+	T t = 0;
+	T s = 0;
+	_coef = a._coef;
+	_series.resize(a._series.size());
+	seriesAdd(a._series.data(), b._series.data(), _series.data(), _series.size(), Ec<T>, t, s);
+	_error = a._error + b._error + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+	return *this;
+}
+
+// то же, что *this = x * a, но без временного ряда
+template <typename T>
+powerSeries<T>& powerSeries<T>::scale(const powerSeries &x, const T &a) {
+	T t = 0;
+	T s = 0;
+	_coef = x._coef;
+	_series.resize(x._series.size());
+	seriesScale(x._series.data(), a, _series.data(), _series.size(), Ec<T>, t, s);
+	_error = x._error * a + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+	return *this;
+}
+
+template <typename T>
+powerSeries<T>& powerSeries<T>::axpy(const powerSeries &x, const T &a) {
+	return axpy(*this, x, a);
+}
+
+// то же, что *this = u + x * a, но за один проход и без временных рядов
+template <typename T>
+powerSeries<T>& powerSeries<T>::axpy(const powerSeries &u, const powerSeries &x, const T &a) {
+	if (u._series.size() != x._series.size())
+		throw notTheSameLength();
+
+	T tx = 0, sx = 0;	// погрешность x * a
+	T t = 0, s = 0;		// погрешность суммы
+	_coef = u._coef;
+	_series.resize(u._series.size());
+	seriesAxpy(u._series.data(), x._series.data(), a, _series.data(), _series.size(), Ec<T>, tx, sx, t, s);
+
+	interval<T> xError = x._error * a + interval<T>(-tx, tx)*Em<T>*E + interval<T>(-sx, sx)*E;
+	_error = u._error + xError + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+	return *this;
+}
+
+// Интеграл x по переменной var от 0, переменная var меняется на [0; 1] (например, время внутри шага).
+// Члены, степень которых после интегрирования больше порядка, уходят в погрешность:
+// на области определения ряда каждый из них по модулю не больше своего коэффициента.
+// Погрешность x интегрируется как var * I, т.е. даёт оболочку I и нуля.
+template <typename T>
+powerSeries<T>& powerSeries<T>::integrate(const powerSeries &x, int var) {
+	if (this == &x) {
+		powerSeries copy(x);
+		return integrate(copy, var);
+	}
+
+	const int linear = x._coef->getVarIndex(var);
 	T t = 0;
 	T s = 0;
-	powerSeries ps;
+	T dropped = 0;
+	_coef = x._coef;
+	_series.assign(x._series.size(), 0);
 
 	for (int i = 0; i < _series.size(); i++) {
-		ps._series.push_back(_series[i] / a);
-		t += ps._series[i];
+		if (x._series[i] == 0)
+			continue;
+
+		T c = x._series[i] / (_coef->getVarOrder(i, var) + 1);
+		int index = (linear == -1) ? -1 : _coef->getMultIndex(i, linear);
+		t += mabs(c);
+		if (index == -1)
+			dropped += mabs(c);
+		else {
+			_series[index] = c;
+			s += flushToZero(_series[index], Ec<T>);
+		}
+	}
+
+	interval<T> hull(std::min(x._error.begin(), (T)0), std::max(x._error.end(), (T)0));
+	_error = hull + interval<T>(-dropped, dropped) + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+	return *this;
+}
+
+// Члены, которые на области определения по модулю не больше eps, уходят в погрешность.
+// bound[k] - наибольший модуль k-го члена с коэффициентом 1 на области определения
+// (1, если переменные меняются на [-1; 1]).
+template <typename T>
+powerSeries<T>& powerSeries<T>::truncate(const vector<T> &bound, T eps) {
+	if (bound.size() != _series.size())
+		throw notTheSameLength();
+
+	T dropped = 0;
+	for (int k = 0; k < _series.size(); k++) {
+		if (_series[k] == 0)
+			continue;
 
-		if (mabs(ps._series[i]) < Ec) {
-			s += mabs(ps._series[i]);
-			ps._series[i] = 0;
+		const T m = mabs(_series[k]) * bound[k];
+		if (m <= eps) {
+			dropped += m;
+			_series[k] = 0;
 		}
 	}
-	ps._error = _error / a + interval<T>(-t, t)*Em*E + interval<T>(-s, s)*E;
+	_error += interval<T>(-dropped, dropped) + interval<T>(-dropped, dropped)*Em<T>*E;
+	return *this;
+}
+
+template <typename T>
+powerSeries<T>& powerSeries<T>::operator/=(const T &a) {
+	if (a == 0)
+		throw divideByZero();
+
+	T t = 0;
+	T s = 0;
+	seriesDiv(_series.data(), a, _series.data(), _series.size(), Ec<T>, t, s);
+	_error = _error / a + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
+	return *this;
+}
+
+template <typename T>
+powerSeries<T> powerSeries<T>::operator/(const T &a) const {
+	if (a == 0)
+		throw divideByZero();
+
+	T t = 0;
+	T s = 0;
+	powerSeries ps(_series.size(), _series.get_allocator(), _coef);
+	seriesDiv(_series.data(), a, ps._series.data(), _series.size(), Ec<T>, t, s);
+	ps._error = _error / a + interval<T>(-t, t)*Em<T>*E + interval<T>(-s, s)*E;
 
 	return ps;
 }
 
+// a / b = a * (1 / b)
+template <typename T>
+powerSeries<T>& powerSeries<T>::operator/=(const powerSeries &ps) {
+	powerSeries inverse(_series.size(), _series.get_allocator(), _coef);
+	inverse.reciprocal(ps);
+	return *this = *this * inverse;
+}
+
+template <typename T>
+powerSeries<T> powerSeries<T>::operator/(const powerSeries &ps) const {
+	powerSeries inverse(_series.size(), _series.get_allocator(), _coef);
+	inverse.reciprocal(ps);
+	powerSeries res(_series.size(), _series.get_allocator(), _coef);
+	res.mul(*this, inverse);
+	return res;
+}
+
+template <typename T>
+powerSeries<T>& powerSeries<T>::shift(const T &c) {
+	T c0 = _series[0] + c;		// член нулевой степени - первый в ряде
+	_series[0] = c0;
+	_error += interval<T>(-mabs(c0), mabs(c0))*Em<T>*E;
+	return *this;
+}
 
+/*
+1 / x итерациями Ньютона y = y + y (1 - x y), начиная с y = 1 / x[0]. Если y верен до степени p - 1,
+то 1 - x y начинается со степени p, и после итерации y верен до степени 2p - 1, поэтому от обоих
+произведений нужны только степени [p; 2p - 1], а остальные члены отбрасываются. Пока y короткий,
+перемножения идут по ненулевым парам и почти ничего не стоят; итераций ceil(log2(order + 1)).
 
+Сам y - просто многочлен, строгая оценка получается проверкой: e = 1 - x y считается со всеми
+погрешностями, и если |e| <= r < 1 на области определения, то 1 / x = y / (1 - e) = y + y e / (1 - e),
+т.е. |1 / x - y| <= |y| r / (1 - r). Иначе (x на области может обратиться в 0) - divideByZero.
+*/
+template <typename T>
+powerSeries<T>& powerSeries<T>::reciprocal(const powerSeries &x) {
+	if (this == &x) {
+		powerSeries copy(x);
+		return reciprocal(copy);
+	}
+	if (x._series[0] == 0)
+		throw divideByZero();
+
+	const int size = x._series.size();
+	_coef = x._coef;
+	_series.assign(size, 0);
+	_series[0] = 1 / x._series[0];
+
+	powerSeries e(size, _series.get_allocator(), _coef), t(size, _series.get_allocator(), _coef);
+	auto keep = [&](powerSeries &ps, int low, int high) {
+		for (int k = 0; k < size; k++) {
+			const int d = _coef->getMultOrder(k);
+			if (d < low || d > high)
+				ps._series[k] = 0;
+		}
+	};
+
+	for (int p = 1; p <= _coef->order(); p *= 2) {
+		e.mul(x, *this);
+		keep(e, p, 2 * p - 1);
+		t.mul(*this, e);
+		keep(t, p, 2 * p - 1);
+		for (int k = 0; k < size; k++)
+			_series[k] -= t._series[k];		// e = x y - 1, без знака
+	}
+	_error = interval<T>(0);
+
+	e.mul(x, *this);
+	e.shift(-1);
+	T r = std::max(mabs(e._error.begin()), mabs(e._error.end()));
+	for (int k = 0; k < size; k++)
+		r += mabs(e._series[k]);
+	r *= 1 + Em<T>*E;
+	if (!(r < 1))
+		throw divideByZero();
+
+	T y = 0;
+	for (int k = 0; k < size; k++)
+		y += mabs(_series[k]);
+	const T bound = y * r / (1 - r) * (1 + 4 * Em<T>*E);
+	_error = interval<T>(-bound, bound);
+	return *this;
+}
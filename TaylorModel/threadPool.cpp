@@ -0,0 +1,85 @@
+﻿#include "threadPool.h"
+
+// поток сейчас выполняет задачу какого-либо пула: вложенные задачи он выполняет сам,
+// иначе пул, занятый внешними задачами, ждал бы сам себя
+static thread_local bool insideTask = false;
+
+threadPool::threadPool(int threads)
+	: _function(nullptr), _task(nullptr), _size(0), _next(0), _busy(0), _generation(0), _stop(false) {
+	for (int i = 1; i < threads; i++)
+		_workers.push_back(std::thread(&threadPool::work, this));
+}
+
+threadPool::~threadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_start.notify_all();
+	for (std::thread &t : _workers)
+		t.join();
+}
+
+void threadPool::work() {
+	long long generation = 0;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_start.wait(lock, [&] { return _stop || _generation != generation; });
+			if (_stop) return;
+			generation = _generation;
+		}
+
+		runTasks();
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (--_busy == 0)
+			_done.notify_one();
+	}
+}
+
+void threadPool::runTasks() {
+	insideTask = true;
+	int i;
+	while ((i = _next++) < _size) {
+		try {
+			_function(_task, i);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!_exception)
+				_exception = std::current_exception();
+		}
+	}
+	insideTask = false;
+}
+
+void threadPool::run(int n, taskFunction function, const void *task) {
+	// второй внешний вызов не ждёт пул и не трогает состояние чужой порции, а считает сам, как и вложенный
+	std::unique_lock<std::mutex> running(_running, std::defer_lock);
+	if (_workers.empty() || n == 1 || insideTask || !running.try_lock()) {
+		for (int i = 0; i < n; i++)
+			function(task, i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_function = function;
+		_task = task;
+		_size = n;
+		_next = 0;
+		_busy = _workers.size();
+		_exception = nullptr;
+		_generation++;
+	}
+	_start.notify_all();
+
+	runTasks();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [&] { return _busy == 0; });
+	if (_exception)
+		std::rethrow_exception(_exception);
+}
@@ -0,0 +1,54 @@
+﻿/*
+Пул потоков для параллельного счёта независимых задач (например, уравнений системы
+на одном этапе метода Рунге-Кутты). Потоки создаются один раз и ждут следующей порции задач.
+Каждая задача выполняется ровно одним потоком, поэтому результат не зависит от того,
+какой поток какую задачу взял.
+*/
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class threadPool {
+	typedef void (*taskFunction)(const void*, int);
+
+private:
+	std::vector<std::thread> _workers;
+	std::mutex _mutex;
+	std::mutex _running;		// занят, пока пул выполняет порцию задач одного из вызывающих потоков
+	std::condition_variable _start;
+	std::condition_variable _done;
+
+	taskFunction _function;
+	const void *_task;
+	int _size;					// задачи 0.._size-1
+	std::atomic<int> _next;		// следующая невзятая задача
+	int _busy;					// сколько потоков ещё работают над текущей порцией
+	long long _generation;		// номер порции задач
+	bool _stop;
+	std::exception_ptr _exception;
+
+	void work();
+	void runTasks();
+	void run(int, taskFunction, const void*);
+
+public:
+	explicit threadPool(int);	// кол-во потоков вместе с вызывающим
+	~threadPool();
+	threadPool(const threadPool&) = delete;
+	threadPool& operator=(const threadPool&) = delete;
+
+	inline int size() const { return _workers.size() + 1; }
+
+	// выполняет task(i) для всех i из [0; n) и ждёт завершения.
+	// Можно вызывать из нескольких потоков сразу: если пул занят чужой порцией, задачи выполняются в вызывающем потоке
+	template <typename F>
+	void run(int n, const F &task) {
+		run(n, [](const void *f, int i) { (*static_cast<const F*>(f))(i); }, &task);
+	}
+};
@@ -1,12 +1,23 @@
 ﻿#include "stdafx.h"
 #include "CppUnitTest.h"
 #include "../TaylorModel/interval.h"
+#include "../TaylorModel/doubleDouble.h"
 #include <algorithm>
+#include <cmath>
+#include <limits>
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 
 namespace intervalClassTest
-{		
+{
+	// границы округлены наружу: [begin; end] внутри интервала, и каждая граница сдвинута не больше чем на 2 ulp
+	static bool encloses(const interval<double> &i, double begin, double end)
+	{
+		const double inf = std::numeric_limits<double>::infinity();
+		double low = std::nextafter(std::nextafter(begin, -inf), -inf);
+		double high = std::nextafter(std::nextafter(end, inf), inf);
+		return i.begin() < begin && i.begin() >= low && i.end() > end && i.end() <= high;
+	}
 
 	TEST_CLASS(UnitTest1)
 	{
@@ -25,7 +36,7 @@ namespace intervalClassTest
 			interval<double> i2(3.8, 2.6);
 
 			i1 += i2;
-			Assert::IsTrue(i1 == interval<double>(1.2 + 3.8, 4.6 + 2.6));
+			Assert::IsTrue(encloses(i1, 1.2 + 3.8, 4.6 + 2.6));
 		}
 
 		TEST_METHOD(TestMethodPlus2)
@@ -34,7 +45,7 @@ namespace intervalClassTest
 			interval<double> i2(3.8, 2.6);
 
 			interval<double> i3 = i1 + i2;
-			Assert::IsTrue(i3 == interval<double>(1.2 + 3.8, 4.6 + 2.6));
+			Assert::IsTrue(encloses(i3, 1.2 + 3.8, 4.6 + 2.6));
 		}
 
 		TEST_METHOD(TestMethodMinus1)
@@ -43,7 +54,7 @@ namespace intervalClassTest
 			interval<double> i2(3.8, 2.6);
 
 			i1 -= i2;
-			Assert::IsTrue(i1 == interval<double>(1.2 - 2.6, 4.6 - 3.8));
+			Assert::IsTrue(encloses(i1, 1.2 - 2.6, 4.6 - 3.8));
 		}
 
 		TEST_METHOD(TestMethodMinus2)
@@ -52,7 +63,7 @@ namespace intervalClassTest
 			interval<double> i2(3.8, 2.6);
 
 			interval<double> i3 = i1 - i2;
-			Assert::IsTrue(i3 == interval<double>(1.2 - 2.6, 4.6 - 3.8));
+			Assert::IsTrue(encloses(i3, 1.2 - 2.6, 4.6 - 3.8));
 		}
 
 		TEST_METHOD(TestMethodMult1)
@@ -64,7 +75,7 @@ namespace intervalClassTest
 			double arr[] = { 1.2*3.8, 4.6*2.6, 1.2*2.6, 4.6*3.8 };
 			double begin = *std::min_element(arr, arr + 4);
 			double end = *std::max_element(arr, arr + 4);
-			Assert::IsTrue(i1 == interval<double>(begin, end));
+			Assert::IsTrue(encloses(i1, begin, end));
 		}
 
 		TEST_METHOD(TestMethodMult2)
@@ -76,7 +87,7 @@ namespace intervalClassTest
 			double arr[] = { 1.2*3.8, 4.6*2.6, 1.2*2.6, 4.6*3.8 };
 			double begin = *std::min_element(arr, arr + 4);
 			double end = *std::max_element(arr, arr + 4);
-			Assert::IsTrue(i3 == interval<double>(begin, end));
+			Assert::IsTrue(encloses(i3, begin, end));
 		}
 
 		TEST_METHOD(TestMethodMult3)
@@ -85,7 +96,7 @@ namespace intervalClassTest
 			double t = 3.0045;
 			i1 *= t;
 
-			Assert::IsTrue(i1 == interval<double>(1.2 * t, 4.6 * t));
+			Assert::IsTrue(encloses(i1, 1.2 * t, 4.6 * t));
 		}
 
 		TEST_METHOD(TestMethodMult4)
@@ -94,7 +105,7 @@ namespace intervalClassTest
 			interval<double> i1(1.2, 4.6);
 			interval<double> i2 = i1 * t;
 
-			Assert::IsTrue(i2 == interval<double>(1.2 * t, 4.6 * t));
+			Assert::IsTrue(encloses(i2, 1.2 * t, 4.6 * t));
 		}
 
 		TEST_METHOD(TestMethodDiv1)
@@ -112,5 +123,65 @@ namespace intervalClassTest
 			Assert::IsTrue(exceptionThrown);
 		}
 
+		TEST_METHOD(TestMethodRounding)
+		{
+			// ни сумма, ни частное не представимы точно: результат с округлением к ближайшему лежит строго внутри
+			interval<double> i1 = interval<double>(0.1) + interval<double>(0.2);
+			Assert::IsTrue(i1.begin() < 0.1 + 0.2 && i1.end() >= 0.1 + 0.2);
+
+			interval<double> i2 = interval<double>(1) / 3.0;
+			Assert::IsTrue(i2.begin() < 1.0 / 3 && i2.end() > 1.0 / 3);
+		}
+
+		TEST_METHOD(TestMethodMultNegative)
+		{
+			interval<double> i1(1.2, 4.6);
+			interval<double> i2 = i1 * -2.0;
+			Assert::IsTrue(encloses(i2, 4.6 * -2.0, 1.2 * -2.0));
+
+			i1 /= -2.0;
+			Assert::IsTrue(encloses(i1, 4.6 / -2.0, 1.2 / -2.0));
+		}
+
+		TEST_METHOD(TestMethodMultSigns)
+		{
+			// все сочетания знаков границ: результат - оболочка четырёх произведений
+			const double v[][2] = { { 1.5, 2.5 }, { -2.5, -1.5 }, { -1.5, 2.5 }, { -2.5, 1.5 } };
+			for (auto &a : v) {
+				for (auto &b : v) {
+					interval<double> i3 = interval<double>(a[0], a[1]) * interval<double>(b[0], b[1]);
+					double arr[] = { a[0] * b[0], a[1] * b[1], a[0] * b[1], a[1] * b[0] };
+					Assert::IsTrue(encloses(i3, *std::min_element(arr, arr + 4), *std::max_element(arr, arr + 4)));
+				}
+			}
+		}
+
+		TEST_METHOD(TestMethodInfinity)
+		{
+			const double inf = std::numeric_limits<double>::infinity();
+			interval<double> i1(-inf, inf);
+			interval<double> i2 = i1 + interval<double>(1, 2);
+			Assert::IsTrue(i2 == interval<double>(-inf, inf));
+
+			interval<double> i3 = interval<double>(1, 2) * i1;
+			Assert::IsTrue(i3 == interval<double>(-inf, inf));
+		}
+
+		TEST_METHOD(TestMethodDoubleDouble)
+		{
+			// 0.1 + 0.2 в doubleDouble точно, 1/3 - нет; границы сдвинуты наружу, но интервал остаётся узким
+			const doubleDouble third = doubleDouble(1) / 3.0;
+			interval<doubleDouble> i1 = interval<doubleDouble>(1) / doubleDouble(3);
+			Assert::IsTrue(i1.begin() < third && i1.end() > third);
+			Assert::IsTrue(i1.end() - i1.begin() < 1e-30);
+
+			interval<doubleDouble> i2 = i1 * doubleDouble(3);
+			Assert::IsTrue(i2.begin() < 1 && i2.end() > 1);
+
+			interval<doubleDouble> i3 = interval<doubleDouble>(0.1) + interval<doubleDouble>(0.2);
+			const doubleDouble sum = doubleDouble::twoSum(0.1, 0.2);
+			Assert::IsTrue(i3.begin() < sum && i3.end() > sum);
+		}
+
 	};
 }
\ No newline at end of file